@@ -248,7 +248,7 @@ struct kissat
 
   /// ADDED
   void *issuer;
-  bool asynch_interrupt;
+  volatile bool asynch_interrupt;
   ExportClause exportClauseCallback;
   ImportUnitClause importUnitCallback;
   ImportClause importClauseCallback;
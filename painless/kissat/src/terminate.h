@@ -15,11 +15,11 @@ kissat_terminated (kissat * solver, int bit,
   assert (0 <= bit), assert (bit < 32);
 #ifdef COVERAGE
   const unsigned mask = 1u << bit;
-  if (!(solver->terminate & mask))
+  if (!(solver->terminate & mask) && !solver->asynch_interrupt)
     return false;
   solver->terminate = ~(unsigned) 0;
 #else
-  if (!solver->terminate)
+  if (!solver->terminate && !solver->asynch_interrupt)
     return false;
 #endif
 #ifndef QUIET
@@ -118,6 +118,7 @@ Solver::Solver() :
 
   , counter            (0)
   , strengthening(false)
+  , keep_trail         (false)
 
     // Resource constraints:
     //
@@ -181,6 +182,7 @@ Solver::Solver(const Solver &s) :
   
   , counter            (s.counter)
   , strengthening      (s.strengthening)
+  , keep_trail         (s.keep_trail)
   
     // Resource constraints:
     //
@@ -1238,7 +1240,7 @@ lbool Solver::search(int& nof_conflicts)
                 restart = lbd_queue.full() && (lbd_queue.avg() * 0.8 > global_lbd_sum / conflicts_VSIDS);
                 cached = true;
             }
-            if (restart /*|| !withinBudget()*/){
+            if (restart || !withinBudget()){
                 lbd_queue.clear();
                 cached = false;
                 // Reached bound on number of conflicts:
@@ -1321,6 +1323,78 @@ void Solver::setStrengthening(bool b) {
     strengthening = b;
 }
 
+void Solver::setKeepTrail(bool b) {
+    keep_trail = b;
+    if (!b) resetTrail();
+}
+
+void Solver::resetTrail() {
+    cancelUntil(0);
+    trail_assumptions.clear();
+}
+
+int Solver::lookaheadCube(const vec<Lit>& cube) {
+    trail_assumptions.clear();
+    cancelUntil(0);
+
+    if (!ok || propagate() != CRef_Undef)
+        return ok = false, -1;
+
+    for (int i = 0; i < cube.size(); i++) {
+        if (value(cube[i]) == l_True)
+            continue;
+
+        if (value(cube[i]) == l_False) {
+            cancelUntil(0);
+            return -1; }
+
+        newDecisionLevel();
+        uncheckedEnqueue(cube[i]);
+
+        if (propagate() != CRef_Undef) {
+            cancelUntil(0);
+            return -1; }
+    }
+
+    return trail.size();
+}
+
+int Solver::lookaheadLit(Lit p) {
+    if (value(p) == l_True)
+        return 0;
+
+    if (value(p) == l_False)
+        return -1;
+
+    int level  = decisionLevel();
+    int before = trail.size();
+
+    newDecisionLevel();
+    uncheckedEnqueue(p);
+
+    bool conflict = propagate() != CRef_Undef;
+    int  assigned = trail.size() - before;
+
+    cancelUntil(level);
+
+    return conflict ? -1 : assigned;
+}
+
+void Solver::lookaheadEnd() {
+    cancelUntil(0);
+}
+
+void Solver::getOccurrences(vec<int>& occ) {
+    occ.growTo(nVars(), 0);
+
+    for (int i = 0; i < clauses.size(); i++) {
+        const Clause& c = ca[clauses[i]];
+
+        for (int j = 0; j < c.size(); j++)
+            occ[var(c[j])]++;
+    }
+}
+
 double Solver::progressEstimate() const
 {
     double  progress = 0;
@@ -1372,6 +1446,16 @@ lbool Solver::solve_()
 
     solves++;
 
+    if (keep_trail){
+        // Backtrack to the last level shared with the previous assumptions:
+        int level = 0;
+        while (level < decisionLevel() && level < assumptions.size() && level < trail_assumptions.size()
+               && trail_assumptions[level] == assumptions[level])
+            level++;
+        cancelUntil(level);
+        assumptions.copyTo(trail_assumptions);
+    }
+
     max_learnts               = nClauses() * learntsize_factor;
     learntsize_adjust_confl   = learntsize_adjust_start_confl;
     learntsize_adjust_cnt     = (int)learntsize_adjust_confl;
@@ -1399,7 +1483,7 @@ lbool Solver::solve_()
         int weighted = phase_allotment;
         fflush(stdout);
 
-        while (status == l_Undef && weighted > 0 /*&& withinBudget()*/)
+        while (status == l_Undef && weighted > 0 && withinBudget())
             if (VSIDS)
                 status = search(weighted);
             else{
@@ -1409,7 +1493,7 @@ lbool Solver::solve_()
                 status = search(nof_conflicts);
             }
 
-        if (status != l_Undef /*|| !withinBudget()*/)
+        if (status != l_Undef || !withinBudget())
             break; // Should break here for correctness in incremental SAT solving.
 
         //VSIDS = !VSIDS;
@@ -1431,7 +1515,8 @@ lbool Solver::solve_()
     }else if (status == l_False && conflict.size() == 0)
         ok = false;
 
-    cancelUntil(0);
+    if (!keep_trail || !ok)
+        cancelUntil(0);
     return status;
 }
 
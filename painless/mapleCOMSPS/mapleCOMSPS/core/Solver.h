@@ -213,6 +213,22 @@ public:
     bool strengthening;
     void setStrengthening(bool b);
 
+    // Keep the decision levels of the assumptions between two calls, the next
+    // call only backtracks to the common prefix of the assumptions.
+    bool keep_trail;
+    vec<Lit> trail_assumptions; // Assumptions of the kept decision levels.
+    void setKeepTrail(bool b);
+    void resetTrail();          // Backtrack to level 0, needed to add clauses.
+
+    // Divide and conquer
+    double varActivity(Var v) const; // Activity of a variable for the current heuristic.
+
+    // Lookahead, without search nor learning
+    int  lookaheadCube(const vec<Lit>& cube); // Propagate a cube at new decision levels, return the number of assigned variables, -1 on conflict.
+    int  lookaheadLit (Lit p);                // Propagate a literal on top of the cube, return the number of newly assigned variables (0 if already true), -1 on conflict.
+    void lookaheadEnd ();                     // Backtrack to level 0.
+    void getOccurrences(vec<int>& occ);       // Number of occurrences of each variable in the problem clauses.
+
 protected:
 
     // Helper structures:
@@ -450,6 +466,7 @@ protected:
 inline CRef Solver::reason(Var x) const { return vardata[x].reason; }
 inline int  Solver::level (Var x) const { return vardata[x].level; }
 
+inline double Solver::varActivity(Var v) const { return VSIDS ? activity_VSIDS[v] : activity_CHB[v]; }
 inline void Solver::insertVarOrder(Var x) {
     Heap<VarOrderLt>& order_heap = VSIDS ? order_heap_VSIDS : order_heap_CHB;
     if (!order_heap.inHeap(x) && decision[x]) order_heap.insert(x); }
@@ -0,0 +1,193 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+// Throughput of the shared clause buffer against the Michael-Scott linked
+// list queue it replaced. Half of the threads produce clauses and the other
+// half consume them, with a growing number of threads.
+//
+// Usage: clause-buffer-bench [clauses] [maxThreads]
+
+#include "../clauses/ClauseBuffer.h"
+#include "../utils/System.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/// Michael-Scott queue used by ClauseBuffer before the ring, kept as the
+/// baseline. A node is allocated per clause. The old version deleted the
+/// dequeued head while other consumers could still read it, so here the
+/// dequeued nodes stay linked and are only freed by the destructor.
+class LinkedQueue
+{
+public:
+   LinkedQueue()
+   {
+      Node * node = new Node(NULL);
+      oldest = head = tail = node;
+   }
+
+   ~LinkedQueue()
+   {
+      while (oldest != NULL) {
+         Node * node = oldest;
+         oldest = node->next.load();
+         delete node;
+      }
+   }
+
+   int addClause(ClauseExchange * clause)
+   {
+      Node * last, * next;
+      Node * node = new Node(clause);
+
+      while (true) {
+         last = tail;
+         next = last->next;
+
+         if (last == tail) {
+            if (next == NULL) {
+               if (last->next.compare_exchange_strong(next, node))
+                  break;
+            } else {
+               tail.compare_exchange_strong(last, next);
+            }
+         }
+      }
+
+      tail.compare_exchange_strong(last, node);
+
+      return 0;
+   }
+
+   bool getClause(ClauseExchange ** clause)
+   {
+      Node * first, * last, * next;
+
+      while (true) {
+         first = head;
+         last  = tail;
+         next  = first->next;
+
+         if (first == head) {
+            if (first == last) {
+               if (next == NULL)
+                  return false;
+
+               tail.compare_exchange_strong(last, next);
+            } else {
+               *clause = next->clause;
+
+               if (head.compare_exchange_strong(first, next))
+                  break;
+            }
+         }
+      }
+
+      return true;
+   }
+
+protected:
+   struct Node
+   {
+      ClauseExchange * clause;
+
+      atomic<Node *> next;
+
+      Node(ClauseExchange * cls)
+      {
+         clause = cls;
+         next   = NULL;
+      }
+   };
+
+   atomic<Node *> head;
+   atomic<Node *> tail;
+
+   /// First node ever allocated, the dequeued nodes follow it.
+   Node * oldest;
+};
+
+/// Return the throughput in millions of clauses per second of a queue with
+/// a given number of producer and consumer threads.
+template<class Queue>
+static double
+measure(int nThreads, long nClauses)
+{
+   Queue queue;
+   ClauseExchange clause;
+   atomic<long> consumed(0);
+   vector<thread> threads;
+
+   int nProducers = nThreads / 2 > 0 ? nThreads / 2 : 1;
+   int nConsumers = nThreads - nProducers > 0 ? nThreads - nProducers : 1;
+   long perThread = nClauses / nProducers;
+   long total     = perThread * nProducers;
+
+   double start = getAbsoluteTime();
+
+   for (int i = 0; i < nProducers; i++) {
+      threads.push_back(thread([&]() {
+         for (long k = 0; k < perThread; k++) {
+            queue.addClause(&clause);
+         }
+      }));
+   }
+
+   for (int i = 0; i < nConsumers; i++) {
+      threads.push_back(thread([&]() {
+         ClauseExchange * cls;
+
+         while (consumed < total) {
+            if (queue.getClause(&cls))
+               consumed++;
+         }
+      }));
+   }
+
+   for (size_t i = 0; i < threads.size(); i++) {
+      threads[i].join();
+   }
+
+   return total / (getAbsoluteTime() - start) / 1e6;
+}
+
+int
+main(int argc, char ** argv)
+{
+   long nClauses  = argc > 1 ? atol(argv[1]) : 2000000;
+   int maxThreads = argc > 2 ? atoi(argv[2]) : 64;
+
+   printf("%d CPUs, %ld clauses per run, Mops/s\n",
+          (int)thread::hardware_concurrency(), nClauses);
+   printf("threads\tlinked\tring\n");
+
+   for (int nThreads = 2; nThreads <= maxThreads; nThreads *= 2) {
+      double linked = measure<LinkedQueue>(nThreads, nClauses);
+      double ring   = measure<ClauseBuffer>(nThreads, nClauses);
+
+      printf("%d\t%.2f\t%.2f\n", nThreads, linked, ring);
+   }
+
+   return 0;
+}
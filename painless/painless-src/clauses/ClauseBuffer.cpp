@@ -18,7 +18,10 @@
 // -----------------------------------------------------------------------------
 
 #include "ClauseBuffer.h"
+#include "../clauses/ClauseManager.h"
 
+#include <algorithm>
+#include <sched.h>
 #include <iostream>
 
 using namespace std;
@@ -26,50 +29,243 @@ using namespace std;
 //-------------------------------------------------
 // Constructor & Destructor
 //-------------------------------------------------
-ClauseBuffer::ClauseBuffer()
+ClauseBuffer::ClauseBuffer(int capacity)
 {
-   ListElement * node = new ListElement(NULL);
-   buffer.head = buffer.tail = node;
-   buffer.size = 0;
+   size_t realCapacity = 2;
+
+   while (realCapacity < capacity) {
+      realCapacity *= 2;
+   }
+
+   cells = new Cell[realCapacity];
+   mask  = realCapacity - 1;
+
+   for (size_t i = 0; i < realCapacity; i++) {
+      cells[i].sequence = i;
+      cells[i].clause   = NULL;
+   }
+
+   enqueuePos   = 0;
+   dequeuePos   = 0;
+   overflowSize = 0;
+   limit        = 0;
+   policy       = DROP_OLDEST;
 }
 
 ClauseBuffer::~ClauseBuffer()
 {
+   delete [] cells;
 }
 
 //-------------------------------------------------
-//  Add clause(s)
+//  Ring operations
 //-------------------------------------------------
-void
-ClauseBuffer::addClause(ClauseExchange * clause)
+bool
+ClauseBuffer::push(ClauseExchange * clause)
 {
-   ListElement * tail, * next;
-   ListElement * node = new ListElement(clause);
+   Cell * cell;
+   size_t pos = enqueuePos.load(memory_order_relaxed);
 
    while (true) {
-      tail = buffer.tail;
-      next = tail->next;
-
-      if (tail == buffer.tail) {
-         if (next == NULL) {
-            if (tail->next.compare_exchange_strong(next, node)) {
-               buffer.size++;
-               break;
-            } 
-         } else {
-            buffer.tail.compare_exchange_strong(tail, next);
-         }
+      cell       = &cells[pos & mask];
+      size_t seq = cell->sequence.load(memory_order_acquire);
+      long dif   = (long)seq - (long)pos;
+
+      if (dif == 0) {
+         if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                              memory_order_relaxed))
+            break;
+      } else if (dif < 0) {
+         return false; // The ring is full
+      } else {
+         pos = enqueuePos.load(memory_order_relaxed);
       }
    }
 
-   buffer.tail.compare_exchange_strong(tail, node);
+   cell->clause = clause;
+   cell->sequence.store(pos + 1, memory_order_release);
+
+   return true;
+}
+
+bool
+ClauseBuffer::pop(ClauseExchange ** clause)
+{
+   Cell * cell;
+   size_t pos = dequeuePos.load(memory_order_relaxed);
+
+   while (true) {
+      cell       = &cells[pos & mask];
+      size_t seq = cell->sequence.load(memory_order_acquire);
+      long dif   = (long)seq - (long)(pos + 1);
+
+      if (dif == 0) {
+         if (dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                              memory_order_relaxed))
+            break;
+      } else if (dif < 0) {
+         return false; // The ring is empty
+      } else {
+         pos = dequeuePos.load(memory_order_relaxed);
+      }
+   }
+
+   *clause = cell->clause;
+   cell->sequence.store(pos + mask + 1, memory_order_release);
+
+   return true;
 }
 
 void
+ClauseBuffer::popAll(vector<ClauseExchange *> & clauses)
+{
+   size_t pos = dequeuePos.load(memory_order_relaxed);
+   size_t end;
+
+   // Claim all the cells reserved by producers at once, the cells are then
+   // synchronized one by one with their producers
+   do {
+      end = enqueuePos.load(memory_order_acquire);
+
+      if ((long)end - (long)pos <= 0)
+         return; // The ring is empty
+   } while (!dequeuePos.compare_exchange_weak(pos, end,
+                                              memory_order_relaxed));
+
+   for (size_t p = pos; p != end; p++) {
+      Cell * cell = &cells[p & mask];
+
+      // A producer may have reserved the cell without having written it yet
+      while (cell->sequence.load(memory_order_acquire) != p + 1) {
+         sched_yield();
+      }
+
+      clauses.push_back(cell->clause);
+      cell->sequence.store(p + mask + 1, memory_order_release);
+   }
+}
+
+//-------------------------------------------------
+//  Limit of the buffer
+//-------------------------------------------------
+void
+ClauseBuffer::setLimit(int maxClauses, OverflowPolicy policy)
+{
+   this->limit  = maxClauses;
+   this->policy = policy;
+}
+
+OverflowPolicy
+ClauseBuffer::parsePolicy(const string & name)
+{
+   if (name == "lbd")
+      return DROP_WORST_LBD;
+
+   if (name == "reject")
+      return REJECT;
+
+   return DROP_OLDEST;
+}
+
+static bool compareLbd(ClauseExchange * a, ClauseExchange * b)
+{
+   return a->lbd < b->lbd;
+}
+
+int
+ClauseBuffer::dropWorstLbd(ClauseExchange * clause)
+{
+   vector<ClauseExchange *> clauses;
+
+   getClauses(clauses);
+   clauses.push_back(clause);
+
+   // Make room for an eighth of the limit to amortize the selection
+   size_t keep = limit - limit / 8;
+
+   if (keep == 0)
+      keep = 1;
+
+   if (clauses.size() <= keep) {
+      for (size_t i = 0; i < clauses.size(); i++) {
+         enqueue(clauses[i]);
+      }
+
+      return 0;
+   }
+
+   nth_element(clauses.begin(), clauses.begin() + keep, clauses.end(),
+               compareLbd);
+
+   for (size_t i = keep; i < clauses.size(); i++) {
+      ClauseManager::releaseClause(clauses[i]);
+   }
+
+   int dropped = clauses.size() - keep;
+
+   clauses.resize(keep);
+
+   for (size_t i = 0; i < clauses.size(); i++) {
+      enqueue(clauses[i]);
+   }
+
+   return dropped;
+}
+
+//-------------------------------------------------
+//  Add clause(s)
+//-------------------------------------------------
+void
+ClauseBuffer::enqueue(ClauseExchange * clause)
+{
+   // The clauses of the overflow list are older than the new one
+   if (overflowSize == 0 && push(clause))
+      return;
+
+   overflowLock.lock();
+   overflow.push_back(clause);
+   overflowSize++;
+   overflowLock.unlock();
+}
+
+int
+ClauseBuffer::addClause(ClauseExchange * clause)
+{
+   if (limit <= 0 || size() < limit) {
+      enqueue(clause);
+      return 0;
+   }
+
+   ClauseExchange * oldest;
+   int dropped = 0;
+
+   switch (policy) {
+      case DROP_OLDEST :
+         if (getClause(&oldest)) {
+            ClauseManager::releaseClause(oldest);
+            dropped = 1;
+         }
+         enqueue(clause);
+         return dropped;
+
+      case DROP_WORST_LBD :
+         return dropWorstLbd(clause);
+
+      default :
+         ClauseManager::releaseClause(clause);
+         return 1;
+   }
+}
+
+int
 ClauseBuffer::addClauses(const vector<ClauseExchange *> & clauses) {
+   int dropped = 0;
+
    for (int i = 0; i < clauses.size(); i++) {
-      addClause(clauses[i]);
+      dropped += addClause(clauses[i]);
    }
+
+   return dropped;
 }
 
 
@@ -78,48 +274,43 @@ ClauseBuffer::addClauses(const vector<ClauseExchange *> & clauses) {
 //-------------------------------------------------
 bool
 ClauseBuffer::getClause(ClauseExchange ** clause) {
-   ListElement * head, * tail, * next;
+   if (pop(clause))
+      return true;
 
-   while (true) {
-      head = buffer.head;
-      tail = buffer.tail;
-      next = head->next;
-
-      if (head == buffer.head) {
-         if (head == tail) {
-            if (next == NULL)
-               return false;
-
-            buffer.tail.compare_exchange_strong(tail, next);
-         } else {
-            *clause = next->clause;
-
-            if (buffer.head.compare_exchange_strong(head, next)) {
-               break;
-            }
-         }
-      }
-   }
+   if (overflowSize == 0)
+      return false;
 
-   delete head;
+   bool found = false;
 
-   buffer.size--;
+   overflowLock.lock();
 
-   return true;
+   if (overflow.size() > 0) {
+      *clause = overflow.front();
+      overflow.pop_front();
+      overflowSize--;
+      found = true;
+   }
+
+   overflowLock.unlock();
+
+   return found;
 }
 
 void
 ClauseBuffer::getClauses(vector<ClauseExchange *> & clauses)
 {
-   ClauseExchange * cls;
+   popAll(clauses);
 
-   int nClauses = size();
-   int nClausesGet = 0;
+   if (overflowSize == 0)
+      return;
 
-   while (getClause(&cls) && nClausesGet < nClauses) {
-      clauses.push_back(cls);
-      nClausesGet++;
-   }
+   overflowLock.lock();
+
+   clauses.insert(clauses.end(), overflow.begin(), overflow.end());
+   overflowSize -= overflow.size();
+   overflow.clear();
+
+   overflowLock.unlock();
 }
 
 //-------------------------------------------------
@@ -128,5 +319,54 @@ ClauseBuffer::getClauses(vector<ClauseExchange *> & clauses)
 int
 ClauseBuffer::size()
 {
-   return buffer.size;
+   size_t enqueue = enqueuePos.load(memory_order_relaxed);
+   size_t dequeue = dequeuePos.load(memory_order_relaxed);
+   long inRing    = (long)enqueue - (long)dequeue;
+
+   if (inRing < 0)
+      inRing = 0;
+
+   return inRing + overflowSize;
+}
+
+//-------------------------------------------------
+//  Clause batch
+//-------------------------------------------------
+ClauseBatch::ClauseBatch()
+{
+   pos = 0;
+}
+
+ClauseBatch::~ClauseBatch()
+{
+   clear();
+}
+
+bool
+ClauseBatch::next(ClauseBuffer & buffer, ClauseExchange ** clause)
+{
+   if (pos == clauses.size()) {
+      clauses.clear();
+      pos = 0;
+
+      buffer.getClauses(clauses);
+
+      if (clauses.empty())
+         return false;
+   }
+
+   *clause = clauses[pos++];
+
+   return true;
+}
+
+void
+ClauseBatch::clear()
+{
+   for (size_t i = pos; i < clauses.size(); i++) {
+      ClauseManager::releaseClause(clauses[i]);
+   }
+
+   clauses.clear();
+   pos = 0;
 }
@@ -20,66 +20,158 @@
 #pragma once
 
 #include "../clauses/ClauseExchange.h"
+#include "../utils/Threading.h"
 
 #include <atomic>
+#include <deque>
 #include <memory>
 #include <stdio.h>
+#include <string>
 #include <vector>
 
 
 using namespace std;
 
+/// Default number of clauses the ring of a buffer can hold.
+#define CLAUSE_BUFFER_CAPACITY 4096
+
+/// Policy applied when a bounded buffer is full.
+enum OverflowPolicy
+{
+   DROP_OLDEST    = 0, ///< Drop the oldest clause of the buffer.
+   DROP_WORST_LBD = 1, ///< Drop the clauses with the highest LBD.
+   REJECT         = 2  ///< Refuse the new clause.
+};
+
 /// Clause buffer is a queue containning shared clauses.
+/// It is a bounded lock-free ring (multi-producers, multi-consumers) with a
+/// preallocated capacity. Clauses that do not fit in the ring of an unbounded
+/// buffer are queued in an overflow list protected by a mutex, so no clause
+/// is ever lost. While the overflow list is not empty, new clauses are
+/// queued after it, so clauses are dequeued in FIFO order. A bounded buffer
+/// applies its policy instead, its limit should not exceed the capacity.
 class ClauseBuffer
 {
 public:
-   /// Constructor.
-   ClauseBuffer();
+   /// Constructor, the capacity is rounded up to a power of two.
+   ClauseBuffer(int capacity = CLAUSE_BUFFER_CAPACITY);
 
    /// Destructor.
    ~ClauseBuffer();
 
+   /// Bound the number of clauses in the buffer, 0 means no limit.
+   /// The size is checked before the clause is enqueued, so with concurrent
+   /// producers the limit is approximate: it may be exceeded by at most one
+   /// clause per producer adding at the same time.
+   void setLimit(int maxClauses, OverflowPolicy policy);
+
    /// Enqueue a shared clause to the buffer.
-   void addClause (ClauseExchange * clause);
+   /// @return the number of clauses dropped (and released) to respect the
+   /// limit of the buffer.
+   int addClause (ClauseExchange * clause);
 
    /// Enqueue shared clauses to the buffer.
-   void addClauses(const vector<ClauseExchange *> & clauses);
+   /// @return the number of clauses dropped to respect the limit.
+   int addClauses(const vector<ClauseExchange *> & clauses);
 
    /// Dequeue a shared clause.
    bool getClause (ClauseExchange ** clause);
 
-   /// Dequeue shared clauses.
+   /// Dequeue all the shared clauses of the buffer at once, the clauses are
+   /// appended to the vector.
    void getClauses(vector<ClauseExchange *> & clauses);
 
    /// Return the current size of the buffer
    int size();
 
+   /// Return the policy corresponding to a name (oldest, lbd or reject).
+   static OverflowPolicy parsePolicy(const string & name);
+
 protected:
-   typedef struct ListElement
+   /// Enqueue a clause without checking the limit.
+   void enqueue(ClauseExchange * clause);
+
+   /// Drop the worst clauses (and the new one if needed) by LBD.
+   int dropWorstLbd(ClauseExchange * clause);
+
+   /// Try to push a clause in the ring, return false if full.
+   bool push(ClauseExchange * clause);
+
+   /// Try to pop a clause from the ring, return false if empty.
+   bool pop(ClauseExchange ** clause);
+
+   /// Pop all the readable clauses of the ring. The range is claimed with a
+   /// single CAS, each cell is then read with one acquire load and given
+   /// back with one release store, waiting for a producer still writing it.
+   void popAll(vector<ClauseExchange *> & clauses);
+
+   typedef struct Cell
    {
+      /// Sequence number used to synchronize producers and consumers.
+      atomic<size_t> sequence;
+
       ClauseExchange * clause;
+   } Cell;
 
-      atomic<ListElement *> next;         
+   /// Cells of the ring.
+   Cell * cells;
 
-      ListElement(ClauseExchange * cls)
-      {
-         next   = NULL;
-         clause = cls;
-      }
+   /// Capacity of the ring minus one.
+   size_t mask;
 
-      ~ListElement()
-      {
-      }
-   } ListElement;
+   /// Padding to keep positions in different cache lines.
+   char pad0[64];
 
-   typedef struct ListRoot
-   {
-      atomic<int> size;
+   /// Position of the next enqueue.
+   atomic<size_t> enqueuePos;
+
+   char pad1[64];
+
+   /// Position of the next dequeue.
+   atomic<size_t> dequeuePos;
 
-      atomic<ListElement *> head;
-      atomic<ListElement *> tail;
-   } ListRoot;
+   char pad2[64];
+
+   /// Number of clauses in the overflow list.
+   atomic<int> overflowSize;
+
+   /// Clauses that did not fit in the ring, in FIFO order.
+   deque<ClauseExchange *> overflow;
+
+   /// Mutex protecting the overflow list.
+   Mutex overflowLock;
+
+   /// Maximum number of clauses, 0 if unbounded.
+   int limit;
+
+   /// Policy applied when the limit is reached.
+   OverflowPolicy policy;
+};
+
+/// Local batch of clauses taken from a clause buffer.
+/// The batch is a member of its consumer (typically a solver importing
+/// clauses) and must only be used by the thread of this consumer. It is
+/// refilled with one batch dequeue when empty, so the shared positions of
+/// the buffer are only touched once per refill.
+class ClauseBatch
+{
+public:
+   /// Constructor.
+   ClauseBatch();
+
+   /// Destructor, releases the clauses not consumed.
+   ~ClauseBatch();
+
+   /// Get the next clause, refilling the batch from the buffer if needed.
+   bool next(ClauseBuffer & buffer, ClauseExchange ** clause);
+
+   /// Release the clauses not consumed.
+   void clear();
+
+protected:
+   /// Clauses of the batch.
+   vector<ClauseExchange *> clauses;
 
-   /// Root of producer/customers lists
-   ListRoot buffer;
+   /// Position of the next clause to consume.
+   size_t pos;
 };
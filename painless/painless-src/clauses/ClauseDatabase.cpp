@@ -21,35 +21,56 @@
 #include "../clauses/ClauseManager.h"
 #include "../clauses/ClauseExchange.h"
 #include "../utils/Logger.h"
+#include "../utils/Parameters.h"
 
+#include <algorithm>
 #include <string.h>
 #include <stdio.h>
 
 using namespace std;
 
-ClauseDatabase::ClauseDatabase()
+/// Maximum capacity of a database in number of literal budgets.
+#define DATABASE_MAX_ROUNDS 8
+
+ClauseDatabase::ClauseDatabase(int literalPerRound)
 {
+   this->literalPerRound = literalPerRound;
+   this->capacity        = 2 * literalPerRound;
+   this->literals        = 0;
+   this->produced        = 0;
+   this->avgProduced     = literalPerRound;
+   this->round           = 0;
+
+   weightLbd  = Parameters::getIntParam("shr-score-lbd", 4);
+   weightSize = Parameters::getIntParam("shr-score-size", 1);
+   weightAge  = Parameters::getIntParam("shr-score-age", 2);
 }
 
 ClauseDatabase::~ClauseDatabase()
 {
+   for (size_t i = 0; i < clauses.size(); i++) {
+      ClauseManager::releaseClause(clauses[i].clause);
+   }
 }
 
 void
 ClauseDatabase::addClause(ClauseExchange * clause)
 {
-	int clsSize = clause->size;
+   DatabaseEntry entry;
 
-	while (clauses.size() < clsSize) {
-      vector<ClauseExchange *> newVector;
-		clauses.push_back(newVector);
-	}
+   entry.clause = clause;
+   entry.round  = round;
+   entry.score  = 0;
 
-   if ((clauses[clsSize-1].size() + 1) * clsSize < 1000) {
-      clauses[clsSize-1].push_back(clause);
-   } else {
-      ClauseManager::releaseClause(clause);
-   }
+   clauses.push_back(entry);
+
+   literals += clause->size;
+   produced += clause->size;
+}
+
+static bool compareScore(const DatabaseEntry & a, const DatabaseEntry & b)
+{
+   return a.score < b.score;
 }
 
 int
@@ -59,37 +80,51 @@ ClauseDatabase::giveSelection(vector<ClauseExchange *> & selectedCls,
    int used     = 0;
    *selectCount = 0;
 
-   for (unsigned i = 0; i < clauses.size(); i++) {
-      unsigned clsSize = i + 1;
-      unsigned left    = totalSize - used;
+   // Keep enough literals for the production of about two rounds
+   avgProduced = 0.75 * avgProduced + 0.25 * produced;
+   produced    = 0;
+   capacity    = max((int)(2 * avgProduced), literalPerRound);
+   capacity    = min(capacity, DATABASE_MAX_ROUNDS * literalPerRound);
 
-      if (left < clsSize) // No more place
-         return used;
-      
-      if (left >= clsSize * clauses[i].size()) {
-         // If all the clauses of size clsSize (i+1) can be added
-         used = used + clsSize * clauses[i].size();
+   for (size_t i = 0; i < clauses.size(); i++) {
+      ClauseExchange * cls = clauses[i].clause;
 
-         selectedCls.insert(selectedCls.end(), clauses[i].begin(),
-                            clauses[i].end());
+      clauses[i].score = weightLbd  * cls->lbd +
+                         weightSize * cls->size +
+                         weightAge  * (round - clauses[i].round);
+   }
 
-         *selectCount += clauses[i].size();
+   stable_sort(clauses.begin(), clauses.end(), compareScore);
 
-         clauses[i].clear();
-      } else {
-         // Else how many clauses can be added
-         // Add them one by one
-         unsigned nCls = left / clsSize;
-         used              = used + clsSize * nCls;
+   size_t nKept = 0;
+   int kept     = 0;
 
-         for (unsigned k = 0; k < nCls; k++) {
-            selectedCls.push_back(clauses[i].back());
-            clauses[i].pop_back();
+   for (size_t i = 0; i < clauses.size(); i++) {
+      ClauseExchange * cls = clauses[i].clause;
+      unsigned left        = totalSize - used;
 
-            *selectCount += 1;
-         }
+      if (left >= cls->size) {
+         selectedCls.push_back(cls);
+         used         += cls->size;
+         *selectCount += 1;
+      } else if (kept + cls->size <= capacity) {
+         // Not selected, kept for the next rounds
+         clauses[nKept++] = clauses[i];
+         kept += cls->size;
+      } else {
+         ClauseManager::releaseClause(cls);
       }
    }
 
+   clauses.resize(nKept);
+   literals = kept;
+   round++;
+
    return used;
 }
+
+int
+ClauseDatabase::getCapacity()
+{
+   return capacity;
+}
@@ -26,25 +26,67 @@
 
 using namespace std;
 
-/// Clause database used for Hordesat
+/// Shared clause waiting in the database.
+struct DatabaseEntry
+{
+   /// Shared clause.
+   ClauseExchange * clause;
+
+   /// Round of the insertion of the clause.
+   unsigned round;
+
+   /// Score of the clause, the lower the better.
+   int score;
+};
+
+/// Database of the clauses exported by a producer.
+/// Clauses are ranked by a score combining their LBD, size and age, and
+/// selected best first within a literal budget. The number of literals kept
+/// between two selections follows the production of the producer.
 class ClauseDatabase
 {
 public:
-   /// Constructor.
-	ClauseDatabase();
+   /// Constructor, the capacity depends on the literal budget of a round.
+   ClauseDatabase(int literalPerRound = 1500);
 
    /// Destructor
-	~ClauseDatabase();
+   ~ClauseDatabase();
 
-	/// Add a shared clause to the database.
-	void addClause(ClauseExchange * clause);
-	 
+   /// Add a shared clause to the database.
+   void addClause(ClauseExchange * clause);
+    
    /// Fill the given buffer with shared clauses.
-	/// @return the number of used literals.
-	int giveSelection(vector<ClauseExchange *> & selectedCls, unsigned totalSize,
+   /// @return the number of used literals.
+   int giveSelection(vector<ClauseExchange *> & selectedCls, unsigned totalSize,
                      int * selectCount);
 
+   /// Return the number of literals the database can keep.
+   int getCapacity();
+
 protected:
-   /// Vector of vector of shared clauses, on vector per size.
-	vector<vector<ClauseExchange *> > clauses;
+   /// Shared clauses of the database.
+   vector<DatabaseEntry> clauses;
+
+   /// Number of literals in the database.
+   int literals;
+
+   /// Number of literals added since the last selection.
+   int produced;
+
+   /// Average number of literals produced per round.
+   double avgProduced;
+
+   /// Literal budget of a round.
+   int literalPerRound;
+
+   /// Number of literals the database can keep.
+   int capacity;
+
+   /// Current round (number of selections).
+   unsigned round;
+
+   /// Weights of the score.
+   int weightLbd;
+   int weightSize;
+   int weightAge;
 };
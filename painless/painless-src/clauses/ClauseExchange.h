@@ -36,6 +36,9 @@ typedef struct ClauseExchange
    /// Id of the solver that has exported this clause.
    int from;
 
+   /// Time of the export of this clause, 0 if unknown.
+   double exportTime;
+
    /// Size of this clause.
    int size;
 
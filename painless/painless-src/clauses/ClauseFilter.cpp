@@ -0,0 +1,157 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/ClauseFilter.h"
+#include "../clauses/ClauseManager.h"
+#include "../solvers/SolverInterface.h"
+#include "../utils/ClauseHash.h"
+#include "../utils/System.h"
+
+#include <new>
+#include <stdlib.h>
+
+using namespace std;
+
+/// Mask of the epoch part of an entry.
+#define FILTER_EPOCH_MASK ((1ULL << FILTER_EPOCH_BITS) - 1)
+
+atomic<uint64_t> * ClauseFilter::table  = NULL;
+uint64_t           ClauseFilter::mask   = 0;
+double             ClauseFilter::window = 1;
+
+void
+ClauseFilter::init(int logBuckets, double window)
+{
+   size_t nBuckets = 1ULL << logBuckets;
+   size_t bytes    = nBuckets * FILTER_BUCKET_SIZE * sizeof(atomic<uint64_t>);
+   void * mem;
+
+   if (posix_memalign(&mem, 64, bytes) != 0)
+      return;
+
+   atomic<uint64_t> * entries = (atomic<uint64_t> *)mem;
+
+   for (size_t i = 0; i < nBuckets * FILTER_BUCKET_SIZE; i++) {
+      new (&entries[i]) atomic<uint64_t>(0);
+   }
+
+   ClauseFilter::mask   = nBuckets - 1;
+   ClauseFilter::window = window > 0 ? window : 1;
+   ClauseFilter::table  = entries;
+}
+
+bool
+ClauseFilter::isEnabled()
+{
+   return table != NULL;
+}
+
+uint64_t
+ClauseFilter::getEpoch()
+{
+   return (uint64_t)(getRelativeTime() / window);
+}
+
+uint64_t
+ClauseFilter::getGroup(const vector<SolverInterface *> & consumers)
+{
+   uint64_t group = 0;
+
+   for (size_t i = 0; i < consumers.size(); i++) {
+      group += mixHash64(consumers[i]->id);
+   }
+
+   return mixHash64(group + consumers.size());
+}
+
+bool
+ClauseFilter::testAndInsert(ClauseExchange * cls, uint64_t epoch,
+                            uint64_t group)
+{
+   uint64_t hash  = hashClause(cls->lits, cls->size) ^ group;
+   uint64_t print = hash >> FILTER_EPOCH_BITS;
+
+   if (print == 0)
+      print = 1; // 0 marks an empty entry
+
+   uint64_t ep    = epoch & FILTER_EPOCH_MASK;
+   uint64_t entry = (print << FILTER_EPOCH_BITS) | ep;
+
+   atomic<uint64_t> * bucket = table + (hash & mask) * FILTER_BUCKET_SIZE;
+
+   while (true) {
+      int victim         = -1;
+      uint64_t oldEntry  = 0;
+      uint64_t victimAge = 0;
+
+      for (int i = 0; i < FILTER_BUCKET_SIZE; i++) {
+         uint64_t value = bucket[i].load(memory_order_relaxed);
+         uint64_t age   = (ep - (value & FILTER_EPOCH_MASK)) & FILTER_EPOCH_MASK;
+
+         if (value != 0 && (value >> FILTER_EPOCH_BITS) == print) {
+            if (age <= 1)
+               return true; // Seen during the window
+
+            // Seen long ago, refresh this entry
+            victim   = i;
+            oldEntry = value;
+            break;
+         }
+
+         if (value == 0)
+            age = FILTER_EPOCH_MASK + 1;
+
+         // Replace the empty or the oldest entry
+         if (victim < 0 || age > victimAge) {
+            victim    = i;
+            oldEntry  = value;
+            victimAge = age;
+         }
+      }
+
+      if (bucket[victim].compare_exchange_strong(oldEntry, entry,
+                                                 memory_order_relaxed))
+         return false;
+   }
+}
+
+int
+ClauseFilter::removeDuplicates(vector<ClauseExchange *> & clauses,
+                               uint64_t group)
+{
+   if (table == NULL)
+      return 0;
+
+   uint64_t epoch = getEpoch();
+   size_t nKept   = 0;
+
+   for (size_t i = 0; i < clauses.size(); i++) {
+      if (testAndInsert(clauses[i], epoch, group)) {
+         ClauseManager::releaseClause(clauses[i]);
+      } else {
+         clauses[nKept++] = clauses[i];
+      }
+   }
+
+   int removed = clauses.size() - nKept;
+
+   clauses.resize(nKept);
+
+   return removed;
+}
@@ -0,0 +1,81 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../clauses/ClauseExchange.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+class SolverInterface;
+
+/// Number of entries of a bucket of the filter, a bucket is a cache line.
+#define FILTER_BUCKET_SIZE 8
+
+/// Bits of an entry used to store the epoch of its insertion.
+#define FILTER_EPOCH_BITS 16
+
+/// Process-wide lock-free filter of the shared clauses.
+/// Each entry stores the fingerprint of a clause hash and the epoch of its
+/// insertion. A clause is a duplicate if its fingerprint has been inserted
+/// during the current or the previous epoch, older entries are overwritten.
+/// Concurrent insertions of the same clause may both succeed, so a few
+/// duplicates can go through.
+/// The clauses are keyed by the group of consumers they are sent to, so a
+/// clause sent to two disjoint groups is not dropped for the second one.
+class ClauseFilter
+{
+public:
+   /// Init the filter with 2^logBuckets buckets and a window in seconds.
+   static void init(int logBuckets, double window);
+
+   /// Return the key of a group of consumers, it does not depend on their
+   /// order.
+   static uint64_t getGroup(const vector<SolverInterface *> & consumers);
+
+   /// Test if a clause is a duplicate for a group, insert it otherwise.
+   static bool testAndInsert(ClauseExchange * cls, uint64_t epoch,
+                             uint64_t group);
+
+   /// Remove and release the duplicates of a list of clauses sent to a
+   /// group of consumers.
+   /// @return the number of removed clauses.
+   static int removeDuplicates(vector<ClauseExchange *> & clauses,
+                               uint64_t group);
+
+   /// Return the current epoch.
+   static uint64_t getEpoch();
+
+   /// Is the filter enabled.
+   static bool isEnabled();
+
+protected:
+   /// Buckets of the filter.
+   static atomic<uint64_t> * table;
+
+   /// Number of buckets minus one.
+   static uint64_t mask;
+
+   /// Duration of an epoch in seconds.
+   static double window;
+};
@@ -0,0 +1,301 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/ClauseLog.h"
+#include "../clauses/ClauseManager.h"
+
+#include <algorithm>
+
+using namespace std;
+
+//-------------------------------------------------
+//  Cursor
+//-------------------------------------------------
+ClauseLogCursor::ClauseLogCursor(ClauseLog * log, int consumer, uint64_t pos,
+                                 LogSegment * segment)
+{
+   this->log       = log;
+   this->consumer  = consumer;
+   this->pos       = pos;
+   this->segment   = segment;
+   this->published = pos;
+   this->busy      = false;
+   this->skip      = NULL;
+   this->closed    = false;
+   this->reached   = pos;
+}
+
+bool
+ClauseLogCursor::next(ClauseExchange ** clause)
+{
+   // Either the writer sees the consumer reading, or the consumer sees the
+   // skip segment given by the writer before reclaiming the older ones
+   busy.store(true);
+
+   LogSegment * target = skip.load();
+
+   if (target != NULL && target->base > pos) {
+      pos     = target->base;
+      segment = target;
+   }
+
+   uint64_t end = log->writePos.load(memory_order_acquire);
+   bool found   = false;
+
+   while (pos != end && found == false) {
+      // The next segment is linked before the entries are published
+      if (pos == segment->base + LOG_SEGMENT_SIZE)
+         segment = segment->next.load(memory_order_acquire);
+
+      LogEntry & entry = segment->entries[pos - segment->base];
+
+      pos++;
+
+      // The segment of the clause may be reclaimed once not busy
+      if (entry.producer != consumer) {
+         ClauseManager::increaseClause(entry.clause, 1);
+         *clause = entry.clause;
+         found   = true;
+      }
+   }
+
+   published.store(pos, memory_order_release);
+   busy.store(false, memory_order_release);
+
+   return found;
+}
+
+//-------------------------------------------------
+//  Log
+//-------------------------------------------------
+ClauseLog::ClauseLog(int maxLag)
+{
+   head     = new LogSegment(0);
+   tail     = head;
+   tailSize = 0;
+   writePos = 0;
+
+   this->maxLag = maxLag > 0 ? maxLag : 0;
+}
+
+ClauseLog::~ClauseLog()
+{
+   while (head != tail) {
+      LogSegment * next = head->next;
+      freeSegment(head, LOG_SEGMENT_SIZE);
+      head = next;
+   }
+
+   freeSegment(tail, tailSize);
+
+   for (size_t i = 0; i < cursors.size(); i++) {
+      delete cursors[i];
+   }
+}
+
+ClauseLogCursor *
+ClauseLog::subscribe(int consumer)
+{
+   ClauseLogCursor * cursor = new ClauseLogCursor(this, consumer, writePos,
+                                                  tail);
+   cursors.push_back(cursor);
+
+   return cursor;
+}
+
+void
+ClauseLog::append(const vector<ClauseExchange *> & clauses, int producer)
+{
+   if (clauses.empty())
+      return;
+
+   for (size_t i = 0; i < clauses.size(); i++) {
+      if (tailSize == LOG_SEGMENT_SIZE) {
+         LogSegment * segment = new LogSegment(tail->base + LOG_SEGMENT_SIZE);
+         tail->next.store(segment, memory_order_release);
+         tail     = segment;
+         tailSize = 0;
+      }
+
+      tail->entries[tailSize].clause   = clauses[i];
+      tail->entries[tailSize].producer = producer;
+      tailSize++;
+   }
+
+   writePos.store(tail->base + tailSize, memory_order_release);
+}
+
+int
+ClauseLog::reclaim()
+{
+   uint64_t end    = writePos.load(memory_order_relaxed);
+   uint64_t minPos = end;
+   int skipped     = 0;
+
+   // Oldest segment within the lag, the lagging consumers are moved to it
+   LogSegment * target = NULL;
+
+   if (maxLag > 0 && end > maxLag) {
+      target = head;
+
+      while (target != tail && target->base < end - maxLag) {
+         target = target->next;
+      }
+   }
+
+   for (size_t i = 0; i < cursors.size();) {
+      ClauseLogCursor * cursor = cursors[i];
+
+      if (cursor->closed.load(memory_order_acquire)) {
+         delete cursor;
+         cursors[i] = cursors.back();
+         cursors.pop_back();
+         continue;
+      }
+
+      uint64_t pos = max(cursor->published.load(memory_order_acquire),
+                         cursor->reached);
+
+      if (target != NULL && pos + maxLag < end && pos < target->base) {
+         cursor->skip.store(target);
+
+         if (cursor->busy.load() == false) {
+            skipped        += target->base - pos;
+            cursor->reached = target->base;
+            pos             = target->base;
+         }
+      }
+
+      if (pos < minPos)
+         minPos = pos;
+
+      i++;
+   }
+
+   // A cursor at the end of a segment may still follow its next pointer
+   while (head != tail && head->base + LOG_SEGMENT_SIZE < minPos) {
+      LogSegment * next = head->next;
+      freeSegment(head, LOG_SEGMENT_SIZE);
+      head = next;
+   }
+
+   return skipped;
+}
+
+void
+ClauseLog::freeSegment(LogSegment * segment, int nEntries)
+{
+   for (int i = 0; i < nEntries; i++) {
+      ClauseManager::releaseClause(segment->entries[i].clause);
+   }
+
+   delete segment;
+}
+
+//-------------------------------------------------
+//  Reader
+//-------------------------------------------------
+ClauseLogReader::ClauseLogReader()
+{
+   for (int i = 0; i < LOG_MAX_CURSORS; i++) {
+      cursors[i] = NULL;
+   }
+
+   nCursors = 0;
+   closed   = false;
+   last     = NULL;
+   current  = 0;
+}
+
+ClauseLogReader::~ClauseLogReader()
+{
+   if (last != NULL)
+      ClauseManager::releaseClause(last);
+}
+
+bool
+ClauseLogReader::addLog(ClauseLog * log, int consumer)
+{
+   int index = nCursors.fetch_add(1);
+
+   if (index >= LOG_MAX_CURSORS)
+      return false;
+
+   ClauseLogCursor * cursor = log->subscribe(consumer);
+
+   cursors[index].store(cursor);
+
+   // Either the reader being closed sees the cursor, or the cursor is
+   // closed here
+   if (closed.load())
+      cursor->closed.store(true, memory_order_release);
+
+   return true;
+}
+
+void
+ClauseLogReader::close()
+{
+   if (last != NULL) {
+      ClauseManager::releaseClause(last);
+      last = NULL;
+   }
+
+   closed.store(true);
+
+   int n = min(nCursors.load(), LOG_MAX_CURSORS);
+
+   for (int i = 0; i < n; i++) {
+      ClauseLogCursor * cursor = cursors[i].exchange(NULL);
+
+      if (cursor != NULL)
+         cursor->closed.store(true, memory_order_release);
+   }
+}
+
+bool
+ClauseLogReader::next(ClauseExchange ** clause)
+{
+   // The previous clause has been consumed
+   if (last != NULL) {
+      ClauseManager::releaseClause(last);
+      last = NULL;
+   }
+
+   if (closed.load(memory_order_relaxed))
+      return false;
+
+   int n = nCursors.load(memory_order_relaxed);
+
+   if (n > LOG_MAX_CURSORS)
+      n = LOG_MAX_CURSORS;
+
+   for (int i = 0; i < n; i++) {
+      ClauseLogCursor * cursor =
+         cursors[(current + i) % n].load(memory_order_acquire);
+
+      if (cursor != NULL && cursor->next(clause)) {
+         current = (current + i) % n;
+         last    = *clause;
+         return true;
+      }
+   }
+
+   return false;
+}
@@ -0,0 +1,212 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../clauses/ClauseExchange.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+/// Number of entries of a segment of the log.
+#define LOG_SEGMENT_SIZE 1024
+
+/// Maximum number of logs a solver can be subscribed to.
+#define LOG_MAX_CURSORS 8
+
+/// Default maximum number of entries a consumer can lag behind the writer.
+#define LOG_MAX_LAG (64 * LOG_SEGMENT_SIZE)
+
+class ClauseLog;
+
+/// Entry of the log.
+struct LogEntry
+{
+   /// Shared clause.
+   ClauseExchange * clause;
+
+   /// Id of the solver that produced the clause.
+   int producer;
+};
+
+/// Segment of the log.
+struct LogSegment
+{
+   /// Constructor.
+   LogSegment(uint64_t base)
+   {
+      this->base = base;
+      this->next = NULL;
+   }
+
+   /// Position of the first entry of this segment in the log.
+   uint64_t base;
+
+   /// Next segment, NULL if this is the last one.
+   atomic<LogSegment *> next;
+
+   /// Entries of this segment.
+   LogEntry entries[LOG_SEGMENT_SIZE];
+};
+
+/// Read cursor of a consumer in a clause log.
+/// The position and segment are only used by the consumer thread, the
+/// published position tells the writer which segments can be reclaimed.
+/// A consumer lagging too far behind is moved forward by the writer: the
+/// writer gives it a skip segment, and only reclaims the segments before
+/// it once it knows the consumer is not reading (busy is false), so the
+/// consumer jumps to the skip segment before reading again.
+class ClauseLogCursor
+{
+public:
+   /// Constructor.
+   ClauseLogCursor(ClauseLog * log, int consumer, uint64_t pos,
+                   LogSegment * segment);
+
+   /// Get the next clause not produced by the consumer, a reference to the
+   /// clause is given to the caller.
+   bool next(ClauseExchange ** clause);
+
+   /// Position published by the consumer.
+   atomic<uint64_t> published;
+
+   /// Is the consumer reading the log.
+   atomic<bool> busy;
+
+   /// Segment the consumer has to skip to, NULL if none.
+   atomic<LogSegment *> skip;
+
+   /// Has the consumer stopped reading, the cursor is then deleted by the
+   /// writer.
+   atomic<bool> closed;
+
+   /// Position the consumer is known to have reached or skipped to, only
+   /// used by the writer.
+   uint64_t reached;
+
+protected:
+   /// Padding to keep the shared fields in their own cache line.
+   char pad[64];
+
+   /// Log read by this cursor.
+   ClauseLog * log;
+
+   /// Id of the consumer.
+   int consumer;
+
+   /// Position of the next entry to read.
+   uint64_t pos;
+
+   /// Segment containing the next entry to read.
+   LogSegment * segment;
+};
+
+/// Append-only broadcast log of shared clauses.
+/// A single writer (the sharer) appends the selected clauses once, every
+/// consumer reads them with its own cursor. A segment is reclaimed, and its
+/// clauses released, once all the cursors have moved past it. A consumer
+/// cannot lag more than maxLag entries behind the writer, the older entries
+/// are skipped and counted as dropped.
+class ClauseLog
+{
+public:
+   /// Constructor.
+   ClauseLog(int maxLag = LOG_MAX_LAG);
+
+   /// Destructor, releases the clauses still in the log.
+   ~ClauseLog();
+
+   /// Create a cursor for a consumer, starting at the end of the log.
+   /// Must be called by the writer thread.
+   ClauseLogCursor * subscribe(int consumer);
+
+   /// Append clauses produced by a solver, the log takes their references.
+   /// Must be called by the writer thread.
+   void append(const vector<ClauseExchange *> & clauses, int producer);
+
+   /// Reclaim the segments read by all the consumers, moving forward the
+   /// lagging ones and deleting the closed ones.
+   /// Must be called by the writer thread.
+   /// @return the number of entries skipped by lagging consumers.
+   int reclaim();
+
+   /// Position of the end of the log.
+   atomic<uint64_t> writePos;
+
+protected:
+   /// Free a segment and release its clauses.
+   void freeSegment(LogSegment * segment, int nEntries);
+
+   /// Oldest segment of the log.
+   LogSegment * head;
+
+   /// Segment currently written.
+   LogSegment * tail;
+
+   /// Number of entries written in the tail segment.
+   int tailSize;
+
+   /// Maximum number of entries a consumer can lag behind, 0 if unbounded.
+   uint64_t maxLag;
+
+   /// Cursors of the consumers.
+   vector<ClauseLogCursor *> cursors;
+};
+
+/// Set of cursors of a consumer, one per log it is subscribed to.
+/// Logs are added by sharer threads while the consumer reads.
+class ClauseLogReader
+{
+public:
+   /// Constructor.
+   ClauseLogReader();
+
+   /// Destructor, releases the last clause returned.
+   ~ClauseLogReader();
+
+   /// Subscribe to a log, return false if too many logs.
+   bool addLog(ClauseLog * log, int consumer);
+
+   /// Get the next clause from one of the logs.
+   /// The clause stays valid until the next call.
+   bool next(ClauseExchange ** clause);
+
+   /// Unsubscribe from all the logs, the consumer stops reading.
+   /// Must be called by the consumer thread, while the logs exist.
+   void close();
+
+protected:
+   /// Cursors of the logs.
+   atomic<ClauseLogCursor *> cursors[LOG_MAX_CURSORS];
+
+   /// Number of reserved cursors.
+   atomic<int> nCursors;
+
+   /// Has the reader been closed.
+   atomic<bool> closed;
+
+   /// Last clause returned, referenced until the next call.
+   ClauseExchange * last;
+
+   /// Index of the cursor tried first.
+   int current;
+};
@@ -23,6 +23,7 @@
 #include <stdlib.h>
 
 #include "../clauses/ClauseExchange.h"
+#include "../clauses/ClausePool.h"
 
 using namespace std;
 
@@ -38,12 +39,11 @@ public:
    /// Alloc a new shared clause.
    static ClauseExchange * allocClause(int size)
    {
-      ClauseExchange * ptr;
-      ptr = (ClauseExchange *) malloc(sizeof(ClauseExchange) + sizeof(int) *
-                                      size);
+      ClauseExchange * ptr = ClausePool::alloc(size);
 
-      ptr->size   = size;
-      ptr->nbRefs = 1;
+      ptr->size       = size;
+      ptr->nbRefs     = 1;
+      ptr->exportTime = 0;
 
       return ptr;
    }
@@ -61,12 +61,13 @@ public:
 
       if (oldValue - 1 <= 0) {
          // Only the last thread should execute this code
-         free(cls);
+         ClausePool::release(cls);
       }
    }
    
    /// Join the clause manager.
    static void joinClauseManager()
    {
+      ClausePool::printStats();
    }
 };
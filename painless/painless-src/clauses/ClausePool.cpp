@@ -0,0 +1,361 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/ClausePool.h"
+#include "../utils/Logger.h"
+#include "../utils/Threading.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+using namespace std;
+
+/// Size in bytes of the blocks of each class.
+static const size_t classSizes[POOL_NB_CLASSES] = {
+   64, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096
+};
+
+/// Per thread cache of free blocks.
+struct ThreadCache
+{
+   /// Blocks freed by other threads, one list per class.
+   alignas(POOL_CACHE_LINE) atomic<PoolBlock *> remote[POOL_NB_CLASSES];
+
+   /// Local free lists, only used by the owner thread.
+   alignas(POOL_CACHE_LINE) PoolBlock * local[POOL_NB_CLASSES];
+
+   /// Blocks of other threads waiting to be given back, one batch per class.
+   PoolBlock * pending[POOL_NB_CLASSES];
+
+   /// Last block of each pending batch.
+   PoolBlock * pendingTail[POOL_NB_CLASSES];
+
+   /// Number of blocks in each pending batch.
+   int pendingCount[POOL_NB_CLASSES];
+
+   /// Is this cache without owner thread.
+   atomic<bool> orphan;
+
+   /// Next cache in the registry.
+   ThreadCache * nextCache;
+
+   /// Counters, only written by the owner thread.
+   atomic<unsigned long> allocations;
+   atomic<unsigned long> poolHits;
+   atomic<unsigned long> largeAllocs;
+   atomic<unsigned long> remoteFrees;
+   atomic<unsigned long> slabs;
+
+   ThreadCache()
+   {
+      for (int c = 0; c < POOL_NB_CLASSES; c++) {
+         remote[c]       = NULL;
+         local[c]        = NULL;
+         pending[c]      = NULL;
+         pendingTail[c]  = NULL;
+         pendingCount[c] = 0;
+      }
+
+      orphan      = false;
+      nextCache   = NULL;
+      allocations = 0;
+      poolHits    = 0;
+      largeAllocs = 0;
+      remoteFrees = 0;
+      slabs       = 0;
+   }
+};
+
+/// Registry of all the caches, caches are never freed.
+static ThreadCache * caches = NULL;
+
+/// Mutex protecting the registry.
+static Mutex cachesLock;
+
+/// Increase a counter only written by its owner thread.
+static inline void bump(atomic<unsigned long> & counter, unsigned long n = 1)
+{
+   counter.store(counter.load(memory_order_relaxed) + n,
+                 memory_order_relaxed);
+}
+
+/// Give a pending batch back to the owner of its blocks.
+static void flushPending(ThreadCache * cache, int c)
+{
+   if (cache->pendingCount[c] == 0)
+      return;
+
+   ThreadCache * owner = cache->pending[c]->owner;
+   PoolBlock * head    = owner->remote[c].load(memory_order_relaxed);
+
+   do {
+      cache->pendingTail[c]->next = head;
+   } while (!owner->remote[c].compare_exchange_weak(head, cache->pending[c],
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+
+   bump(cache->remoteFrees, cache->pendingCount[c]);
+
+   cache->pending[c]      = NULL;
+   cache->pendingTail[c]  = NULL;
+   cache->pendingCount[c] = 0;
+}
+
+/// Take an orphan cache or create a new one.
+static ThreadCache * acquireCache()
+{
+   ThreadCache * cache;
+
+   cachesLock.lock();
+
+   for (cache = caches; cache != NULL; cache = cache->nextCache) {
+      bool expected = true;
+
+      if (cache->orphan.compare_exchange_strong(expected, false))
+         break;
+   }
+
+   if (cache == NULL) {
+      void * mem;
+
+      if (posix_memalign(&mem, POOL_CACHE_LINE, sizeof(ThreadCache)) != 0) {
+         cachesLock.unlock();
+         return NULL;
+      }
+
+      cache            = new (mem) ThreadCache();
+      cache->nextCache = caches;
+      caches           = cache;
+   }
+
+   cachesLock.unlock();
+
+   return cache;
+}
+
+/// Holder of the cache of a thread, the cache is orphaned at thread exit.
+/// A thread releasing clauses after that has no cache anymore, its blocks
+/// are given back directly to their owners.
+struct CacheHolder
+{
+   ThreadCache * cache;
+
+   /// Has the cache been orphaned.
+   bool exited;
+
+   CacheHolder()
+   {
+      cache  = NULL;
+      exited = false;
+   }
+
+   ~CacheHolder()
+   {
+      exited = true;
+
+      if (cache == NULL)
+         return;
+
+      for (int c = 0; c < POOL_NB_CLASSES; c++) {
+         flushPending(cache, c);
+      }
+
+      // The cache may be adopted by another thread from now on
+      ThreadCache * orphaned = cache;
+
+      cache            = NULL;
+      orphaned->orphan = true;
+   }
+};
+
+static thread_local CacheHolder holder;
+
+/// Return the cache of the calling thread, NULL if none.
+static inline ThreadCache * getCache()
+{
+   if (holder.cache == NULL && holder.exited == false)
+      holder.cache = acquireCache();
+
+   return holder.cache;
+}
+
+/// Return the size class of a clause, -1 if too big for the pool.
+static inline int getSizeClass(size_t bytes)
+{
+   for (int c = 0; c < POOL_NB_CLASSES; c++) {
+      if (bytes <= classSizes[c])
+         return c;
+   }
+
+   return -1;
+}
+
+/// Cut a new slab into blocks of a given class.
+static bool refill(ThreadCache * cache, int c)
+{
+   void * mem;
+
+   if (posix_memalign(&mem, POOL_CACHE_LINE, POOL_SLAB_SIZE) != 0)
+      return false;
+
+   char * slab      = (char *)mem;
+   size_t blockSize = classSizes[c];
+   size_t nBlocks   = POOL_SLAB_SIZE / blockSize;
+
+   for (size_t i = 0; i < nBlocks; i++) {
+      PoolBlock * block = (PoolBlock *)(slab + i * blockSize);
+      block->owner      = cache;
+      block->sizeClass  = c;
+      block->next       = cache->local[c];
+      cache->local[c]   = block;
+   }
+
+   bump(cache->slabs);
+
+   return true;
+}
+
+ClauseExchange *
+ClausePool::alloc(int size)
+{
+   size_t bytes        = sizeof(PoolBlock) + sizeof(ClauseExchange) +
+                         sizeof(int) * size;
+   int c               = getSizeClass(bytes);
+   ThreadCache * cache = getCache();
+   PoolBlock * block;
+
+   if (c < 0 || cache == NULL) {
+      block = (PoolBlock *)malloc(bytes);
+
+      block->owner     = NULL;
+      block->sizeClass = -1;
+
+      if (cache != NULL) {
+         bump(cache->allocations);
+         bump(cache->largeAllocs);
+      }
+
+      return (ClauseExchange *)(block + 1);
+   }
+
+   bump(cache->allocations);
+
+   if (cache->local[c] == NULL) {
+      // Take all the blocks given back by other threads at once
+      cache->local[c] = cache->remote[c].exchange(NULL, memory_order_acquire);
+
+      if (cache->local[c] == NULL) {
+         if (refill(cache, c) == false)
+            return NULL;
+      } else {
+         bump(cache->poolHits);
+      }
+   } else {
+      bump(cache->poolHits);
+   }
+
+   block           = cache->local[c];
+   cache->local[c] = block->next;
+
+   return (ClauseExchange *)(block + 1);
+}
+
+void
+ClausePool::release(ClauseExchange * cls)
+{
+   PoolBlock * block = ((PoolBlock *)cls) - 1;
+
+   if (block->owner == NULL) {
+      free(block);
+      return;
+   }
+
+   ThreadCache * cache = getCache();
+   int c               = block->sizeClass;
+
+   if (block->owner == cache) {
+      block->next     = cache->local[c];
+      cache->local[c] = block;
+      return;
+   }
+
+   if (cache == NULL) {
+      // No local cache, give the block back directly
+      PoolBlock * head = block->owner->remote[c].load(memory_order_relaxed);
+
+      do {
+         block->next = head;
+      } while (!block->owner->remote[c].compare_exchange_weak(head, block,
+                                                     memory_order_release,
+                                                     memory_order_relaxed));
+      return;
+   }
+
+   // A batch only contains blocks of a single owner
+   if (cache->pendingCount[c] > 0 && cache->pending[c]->owner != block->owner)
+      flushPending(cache, c);
+
+   block->next       = cache->pending[c];
+   cache->pending[c] = block;
+
+   if (cache->pendingCount[c] == 0)
+      cache->pendingTail[c] = block;
+
+   cache->pendingCount[c]++;
+
+   if (cache->pendingCount[c] >= POOL_REMOTE_BATCH)
+      flushPending(cache, c);
+}
+
+ClausePoolStatistics
+ClausePool::getStatistics()
+{
+   ClausePoolStatistics stats;
+
+   cachesLock.lock();
+
+   for (ThreadCache * cache = caches; cache != NULL;
+        cache = cache->nextCache)
+   {
+      stats.allocations += cache->allocations.load(memory_order_relaxed);
+      stats.poolHits    += cache->poolHits.load(memory_order_relaxed);
+      stats.largeAllocs += cache->largeAllocs.load(memory_order_relaxed);
+      stats.remoteFrees += cache->remoteFrees.load(memory_order_relaxed);
+      stats.slabs       += cache->slabs.load(memory_order_relaxed);
+   }
+
+   cachesLock.unlock();
+
+   return stats;
+}
+
+void
+ClausePool::printStats()
+{
+   ClausePoolStatistics stats = getStatistics();
+
+   double hitRate = stats.allocations == 0 ? 0 :
+                    (100.0 * stats.poolHits) / stats.allocations;
+
+   log(1, "Clause pool: %lu allocations, %.2f%% pool hits, %lu large, " \
+       "%lu remote frees, %lu slabs (%lu KB)\n", stats.allocations, hitRate,
+       stats.largeAllocs, stats.remoteFrees, stats.slabs,
+       stats.slabs * POOL_SLAB_SIZE / 1024);
+}
@@ -0,0 +1,90 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../clauses/ClauseExchange.h"
+
+using namespace std;
+
+/// Number of size classes, bigger clauses are allocated with malloc.
+#define POOL_NB_CLASSES 12
+
+/// Size of a cache line, every block starts on a cache line.
+#define POOL_CACHE_LINE 64
+
+/// Size of the slabs carved into blocks.
+#define POOL_SLAB_SIZE (64 * 1024)
+
+/// Number of remotely freed blocks kept before giving them back to the owner.
+#define POOL_REMOTE_BATCH 32
+
+struct ThreadCache;
+
+/// Header placed in front of every shared clause allocated by the pool.
+struct PoolBlock
+{
+   /// Thread cache owning this block, NULL if allocated with malloc.
+   ThreadCache * owner;
+
+   /// Next block in a free list.
+   PoolBlock * next;
+
+   /// Size class of the block.
+   int sizeClass;
+};
+
+/// Statistics of the clause pool.
+struct ClausePoolStatistics
+{
+   /// Constructor.
+   ClausePoolStatistics()
+   {
+      allocations = 0;
+      poolHits    = 0;
+      largeAllocs = 0;
+      remoteFrees = 0;
+      slabs       = 0;
+   }
+
+   unsigned long allocations; ///< Number of allocated clauses.
+   unsigned long poolHits;    ///< Allocations served by a free list.
+   unsigned long largeAllocs; ///< Allocations too big for the pool.
+   unsigned long remoteFrees; ///< Frees of blocks owned by another thread.
+   unsigned long slabs;       ///< Number of slabs allocated.
+};
+
+/// Thread-caching size-class allocator for shared clauses.
+/// Each thread allocates from its own free lists. A block freed by another
+/// thread is batched and given back to the owner through a lock-free list.
+class ClausePool
+{
+public:
+   /// Allocate a shared clause of the given size.
+   static ClauseExchange * alloc(int size);
+
+   /// Give back a shared clause to the pool.
+   static void release(ClauseExchange * cls);
+
+   /// Return the cumulated statistics of all the thread caches.
+   static ClausePoolStatistics getStatistics();
+
+   /// Print the statistics of the pool.
+   static void printStats();
+};
@@ -0,0 +1,300 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/ClauseManager.h"
+#include "../clauses/ShmClauseRing.h"
+#include "../utils/Logger.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/// Magic number of an initialized segment.
+#define SHM_MAGIC 0x7061696e6c657373ULL
+
+static_assert(sizeof(ShmSlot) == 256, "a slot should be 256 bytes");
+
+ShmClauseRing::ShmClauseRing(const string & name, int logSlots, uint64_t key)
+{
+   this->name     = name;
+   this->header   = NULL;
+   this->slots    = NULL;
+   this->bytes    = 0;
+   this->mask     = 0;
+   this->origin   = getpid();
+   this->attached = false;
+   this->pushed   = 0;
+   this->lost     = 0;
+
+   uint64_t nSlots = 1ULL << logSlots;
+   void * mem;
+
+   // The first process creates and initializes the segment
+   int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+   if (fd >= 0) {
+      bytes = sizeof(ShmHeader) + nSlots * sizeof(ShmSlot);
+
+      if (ftruncate(fd, bytes) != 0) {
+         close(fd);
+         shm_unlink(name.c_str());
+         log(0, "Cannot allocate the shared memory segment %s\n",
+             name.c_str());
+         return;
+      }
+
+      mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+
+      if (mem == MAP_FAILED) {
+         shm_unlink(name.c_str());
+         log(0, "Cannot map the shared memory segment %s\n", name.c_str());
+         return;
+      }
+
+      // The segment is zero filled, so are the sequence numbers
+      header         = (ShmHeader *)mem;
+      header->nSlots = nSlots;
+      header->key    = key;
+      header->attached.store(1);
+      header->tail.store(0);
+      header->magic.store(SHM_MAGIC, memory_order_release);
+   } else {
+      fd = shm_open(name.c_str(), O_RDWR, 0600);
+
+      if (fd < 0) {
+         log(0, "Cannot open the shared memory segment %s\n", name.c_str());
+         return;
+      }
+
+      // Wait for the creator to size the segment, the number of slots is
+      // the one of the creator
+      struct stat st;
+
+      for (int i = 0; i < 1000; i++) {
+         if (fstat(fd, &st) == 0 && st.st_size >= sizeof(ShmHeader))
+            break;
+         usleep(1000);
+      }
+
+      ShmHeader * tmp = (ShmHeader *)mmap(NULL, sizeof(ShmHeader),
+                                          PROT_READ | PROT_WRITE, MAP_SHARED,
+                                          fd, 0);
+
+      if (tmp == MAP_FAILED) {
+         close(fd);
+         log(0, "Cannot map the shared memory segment %s\n", name.c_str());
+         return;
+      }
+
+      for (int i = 0; i < 1000; i++) {
+         if (tmp->magic.load(memory_order_acquire) == SHM_MAGIC)
+            break;
+         usleep(1000);
+      }
+
+      if (tmp->magic.load(memory_order_acquire) != SHM_MAGIC) {
+         munmap(tmp, sizeof(ShmHeader));
+         close(fd);
+         log(0, "The shared memory segment %s is not initialized\n",
+             name.c_str());
+         return;
+      }
+
+      nSlots = tmp->nSlots;
+      bytes  = sizeof(ShmHeader) + nSlots * sizeof(ShmSlot);
+
+      bool sameFormula = tmp->key == key;
+
+      munmap(tmp, sizeof(ShmHeader));
+
+      if (sameFormula == false) {
+         close(fd);
+         log(0, "The shared memory segment %s is used for another formula\n",
+             name.c_str());
+         return;
+      }
+
+      mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+
+      if (mem == MAP_FAILED) {
+         log(0, "Cannot map the shared memory segment %s\n", name.c_str());
+         return;
+      }
+
+      header = (ShmHeader *)mem;
+      header->attached.fetch_add(1);
+   }
+
+   this->slots    = (ShmSlot *)(header + 1);
+   this->mask     = nSlots - 1;
+   this->attached = true;
+}
+
+ShmClauseRing::~ShmClauseRing()
+{
+   detach();
+
+   if (header != NULL) {
+      munmap(header, bytes);
+   }
+}
+
+bool
+ShmClauseRing::isOpen()
+{
+   return header != NULL;
+}
+
+void
+ShmClauseRing::detach()
+{
+   if (attached.exchange(false) == false)
+      return;
+
+   if (header->attached.fetch_sub(1) == 1) {
+      shm_unlink(name.c_str());
+   }
+}
+
+bool
+ShmClauseRing::push(ClauseExchange * clause)
+{
+   if (clause->size > SHM_SLOT_LITS)
+      return false;
+
+   uint64_t pos   = header->tail.fetch_add(1);
+   ShmSlot * slot = &slots[pos & mask];
+
+   // The odd sequence number invalidates the slot before its payload changes
+   slot->seq.store(2 * pos + 1, memory_order_relaxed);
+   atomic_thread_fence(memory_order_release);
+
+   slot->size.store(clause->size, memory_order_relaxed);
+   slot->lbd.store(clause->lbd, memory_order_relaxed);
+   slot->origin.store(origin, memory_order_relaxed);
+
+   for (int i = 0; i < clause->size; i++) {
+      slot->lits[i].store(clause->lits[i], memory_order_relaxed);
+   }
+
+   slot->seq.store(2 * pos + 2, memory_order_release);
+
+   pushed++;
+
+   return true;
+}
+
+ShmCursor
+ShmClauseRing::getCursor()
+{
+   ShmCursor cursor;
+
+   cursor.pos = header->tail.load(memory_order_acquire);
+
+   return cursor;
+}
+
+void
+ShmClauseRing::read(ShmCursor & cursor, vector<ClauseExchange *> & clauses)
+{
+   uint64_t tail = header->tail.load(memory_order_acquire);
+   int lits[SHM_SLOT_LITS];
+
+   // The slots overwritten since the last read are lost
+   if (tail - cursor.pos > mask + 1) {
+      lost          += tail - (mask + 1) - cursor.pos;
+      cursor.pos     = tail - (mask + 1);
+      cursor.stalls  = 0;
+   }
+
+   while (cursor.pos < tail) {
+      ShmSlot * slot = &slots[cursor.pos & mask];
+      uint64_t seq   = slot->seq.load(memory_order_acquire);
+      uint64_t done  = 2 * cursor.pos + 2;
+
+      if (seq < done) {
+         // Still written, or its writer is dead
+         if (++cursor.stalls <= SHM_MAX_STALLS)
+            break;
+
+         lost++;
+         cursor.pos++;
+         cursor.stalls = 0;
+         continue;
+      }
+
+      cursor.pos++;
+      cursor.stalls = 0;
+
+      if (seq > done) {
+         lost++;
+         continue;
+      }
+
+      int size   = slot->size.load(memory_order_relaxed);
+      int lbd    = slot->lbd.load(memory_order_relaxed);
+      int writer = slot->origin.load(memory_order_relaxed);
+
+      if (size < 0 || size > SHM_SLOT_LITS)
+         size = 0;
+
+      for (int i = 0; i < size; i++) {
+         lits[i] = slot->lits[i].load(memory_order_relaxed);
+      }
+
+      // The slot may have been rewritten during the copy
+      atomic_thread_fence(memory_order_acquire);
+
+      if (slot->seq.load(memory_order_relaxed) != seq) {
+         lost++;
+         continue;
+      }
+
+      if (writer == origin || size == 0)
+         continue;
+
+      ClauseExchange * cls = ClauseManager::allocClause(size);
+
+      cls->lbd  = lbd;
+      cls->from = -1;
+
+      for (int i = 0; i < size; i++) {
+         cls->lits[i] = lits[i];
+      }
+
+      clauses.push_back(cls);
+   }
+}
+
+unsigned long
+ShmClauseRing::getPushed()
+{
+   return pushed;
+}
+
+unsigned long
+ShmClauseRing::getLost()
+{
+   return lost;
+}
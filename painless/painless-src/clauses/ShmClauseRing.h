@@ -0,0 +1,154 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../clauses/ClauseExchange.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// Maximum number of literals of a clause in the ring, a slot is 256 bytes.
+#define SHM_SLOT_LITS 59
+
+/// Number of reads a reader waits for a slot being written before skipping
+/// it, the writer may have died.
+#define SHM_MAX_STALLS 8
+
+/// Slot of the ring, the payload is valid if the sequence number is even
+/// and has not changed while being read.
+struct ShmSlot
+{
+   /// 2 * position + 1 while written, 2 * position + 2 once written.
+   atomic<uint64_t> seq;
+
+   /// Size, LBD and writing process of the clause.
+   atomic<int> size;
+   atomic<int> lbd;
+   atomic<int> origin;
+
+   /// Literals of the clause.
+   atomic<int> lits[SHM_SLOT_LITS];
+};
+
+/// Header of the shared memory segment.
+struct ShmHeader
+{
+   /// Set once the segment is initialized.
+   atomic<uint64_t> magic;
+
+   /// Number of slots, a power of two.
+   uint64_t nSlots;
+
+   /// Key of the formula solved by the processes.
+   uint64_t key;
+
+   /// Number of processes attached to the segment.
+   atomic<int> attached;
+
+   /// Position of the next slot to write, on its own cache line.
+   alignas(64) atomic<uint64_t> tail;
+};
+
+/// Position of a reader in the ring.
+struct ShmCursor
+{
+   /// Constructor.
+   ShmCursor()
+   {
+      pos    = 0;
+      stalls = 0;
+   }
+
+   /// Position of the next slot to read.
+   uint64_t pos;
+
+   /// Number of reads blocked on the slot at pos.
+   int stalls;
+};
+
+/// Ring of shared clauses in a POSIX shared memory segment, exchanging
+/// clauses between the painless processes of a host.
+/// Writers of any process reserve a slot with a fetch_add on the tail, the
+/// ring is never full: old slots are overwritten and a late reader skips
+/// them. Readers are not known by the writers, each one has its own cursor.
+class ShmClauseRing
+{
+public:
+   /// Open the segment of a given name, it is created with 2^logSlots slots
+   /// if it does not exist. The processes must solve the same formula,
+   /// identified by a key, or the segment is not opened.
+   ShmClauseRing(const string & name, int logSlots, uint64_t key);
+
+   /// Destructor, detach and unmap the segment.
+   ~ShmClauseRing();
+
+   /// Is the segment mapped.
+   bool isOpen();
+
+   /// Detach the process from the segment, the last process removes its
+   /// name. The mapping stays valid.
+   void detach();
+
+   /// Write a clause, return false if the clause is too long.
+   bool push(ClauseExchange * clause);
+
+   /// Return a cursor on the next slot to be written.
+   ShmCursor getCursor();
+
+   /// Read the clauses written by other processes since a cursor, the
+   /// cursor is then advanced.
+   void read(ShmCursor & cursor, vector<ClauseExchange *> & clauses);
+
+   /// Return the number of written clauses.
+   unsigned long getPushed();
+
+   /// Return the number of slots skipped by the readers of the process.
+   unsigned long getLost();
+
+protected:
+   /// Name of the segment.
+   string name;
+
+   /// Mapping of the segment, NULL if the segment is not open.
+   ShmHeader * header;
+
+   /// Slots of the ring.
+   ShmSlot * slots;
+
+   /// Size of the mapping in bytes.
+   size_t bytes;
+
+   /// Mask of a position in the ring.
+   uint64_t mask;
+
+   /// Id of the process.
+   int origin;
+
+   /// Is the process attached.
+   atomic<bool> attached;
+
+   /// Number of written clauses and skipped slots.
+   atomic<unsigned long> pushed;
+   atomic<unsigned long> lost;
+};
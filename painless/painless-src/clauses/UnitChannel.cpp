@@ -0,0 +1,115 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/UnitChannel.h"
+#include "../painless.h"
+
+#include <stdlib.h>
+
+using namespace std;
+
+atomic<signed char> * UnitChannel::values   = NULL;
+atomic<int> *         UnitChannel::units    = NULL;
+atomic<int>           UnitChannel::nUnits(0);
+int                   UnitChannel::nVars    = 0;
+atomic<bool>          UnitChannel::conflict(false);
+
+void
+UnitChannel::init(int nVars)
+{
+   atomic<signed char> * newValues = new atomic<signed char>[nVars + 1];
+   atomic<int> * newUnits          = new atomic<int>[nVars];
+
+   for (int i = 0; i <= nVars; i++) {
+      newValues[i] = 0;
+   }
+
+   for (int i = 0; i < nVars; i++) {
+      newUnits[i] = 0;
+   }
+
+   UnitChannel::nVars  = nVars;
+   UnitChannel::units  = newUnits;
+   UnitChannel::values = newValues;
+}
+
+bool
+UnitChannel::isEnabled()
+{
+   return values != NULL;
+}
+
+bool
+UnitChannel::addUnit(int lit)
+{
+   int var          = abs(lit);
+   signed char sign = lit > 0 ? 1 : -1;
+
+   if (var > nVars)
+      return true;
+
+   signed char value = values[var].load(memory_order_relaxed);
+
+   if (value == 0 &&
+       values[var].compare_exchange_strong(value, sign, memory_order_relaxed))
+   {
+      // Each variable is added once, so the list never overflows
+      int index = nUnits.fetch_add(1, memory_order_relaxed);
+      units[index].store(lit, memory_order_release);
+      return true;
+   }
+
+   if (value != sign) {
+      conflict = true;
+      endingSignal.signal();
+      return false;
+   }
+
+   return true;
+}
+
+bool
+UnitChannel::nextUnit(int & cursor, int * lit)
+{
+   if (cursor >= nUnits.load(memory_order_relaxed))
+      return false;
+
+   // The unit may be reserved but not yet written
+   int unit = units[cursor].load(memory_order_acquire);
+
+   if (unit == 0)
+      return false;
+
+   cursor++;
+   *lit = unit;
+
+   return true;
+}
+
+bool
+UnitChannel::hasConflict()
+{
+   return conflict;
+}
+
+int
+UnitChannel::getUnitsCount()
+{
+   return nUnits;
+}
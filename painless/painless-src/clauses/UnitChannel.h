@@ -0,0 +1,68 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+
+using namespace std;
+
+/// Process-wide channel of the learned units.
+/// Exporters write a unit once in an assignment array indexed by variable,
+/// the first assignment of a variable is appended to a list read by every
+/// solver with its own cursor. Units are then never duplicated and do not
+/// go through the sharers. Two opposite units mean that the formula is
+/// unsatisfiable.
+class UnitChannel
+{
+public:
+   /// Init the channel for a given number of variables.
+   static void init(int nVars);
+
+   /// Is the channel enabled.
+   static bool isEnabled();
+
+   /// Add a unit, return false if its negation is already in the channel.
+   static bool addUnit(int lit);
+
+   /// Get the next unit after a cursor, the cursor is then advanced.
+   static bool nextUnit(int & cursor, int * lit);
+
+   /// Have two opposite units been added.
+   static bool hasConflict();
+
+   /// Return the number of units in the channel.
+   static int getUnitsCount();
+
+protected:
+   /// Value of each variable, 0 if unknown, 1 if true and -1 if false.
+   static atomic<signed char> * values;
+
+   /// Units in the order of their addition, 0 if not yet written.
+   static atomic<int> * units;
+
+   /// Number of units reserved in the list.
+   static atomic<int> nUnits;
+
+   /// Number of variables.
+   static int nVars;
+
+   /// Have two opposite units been added.
+   static atomic<bool> conflict;
+};
@@ -21,18 +21,27 @@
 #include "utils/Parameters.h"
 #include "utils/System.h"
 #include "utils/SatUtils.h"
+#include "utils/Topology.h"
 
 #include "solvers/SolverFactory.h"
 
+#include "clauses/ClauseFilter.h"
 #include "clauses/ClauseManager.h"
+#include "clauses/ShmClauseRing.h"
+#include "clauses/UnitChannel.h"
 
 #include "sharing/HordeSatSharing.h"
+#include "sharing/MpiSharing.h"
+#include "sharing/ShmSharing.h"
 #include "sharing/StrengtheningSharing.h"
 #include "sharing/Sharer.h"
 
+#include "working/CubeGenerator.h"
+#include "working/DivideAndConquer.h"
 #include "working/SequentialWorker.h"
 #include "working/Portfolio.h"
 
+#include <stdio.h>
 #include <unistd.h>
 
 
@@ -44,6 +53,8 @@ using namespace std;
 // -------------------------------------------
 atomic<bool> globalEnding(false);
 
+Condition endingSignal;
+
 Sharer ** sharers = NULL;
 
 int nSharers = 0;
@@ -60,6 +71,8 @@ vector<int> finalModel;
 // -------------------------------------------
 int main(int argc, char ** argv)
 {
+   MpiSharing::init(&argc, &argv);
+
    Parameters::init(argc, argv);
 
    if (Parameters::getFilename() == NULL ||
@@ -74,10 +87,89 @@ int main(int argc, char ** argv)
       cout << "\t-lbd-limit=<INT>\t LBD limit of exported clauses, default is" \
 	      " 2" << endl;
       cout << "\t-shr-sleep=<INT>\t time in useconds a sharer sleep each " \
-         "round, default is 500000 (0.5s)" << endl;
+         "round if not woken up by the producers, default is 500000 (0.5s)" \
+         << endl;
+      cout << "\t-shr-min-sleep=<INT>\t minimal time in useconds between two " \
+         "rounds, default is shr-sleep/10" << endl;
+      cout << "\t-shr-max-sleep=<INT>\t maximal time in useconds a sharer " \
+         "sleeps when nothing is exported, default is 4*shr-sleep" << endl;
+      cout << "\t-shr-wake-lit=<INT>\t number of exported literals waking up " \
+         "a sharer, default is shr-lit" << endl;
+      cout << "\t-shr-wake-lbd=<INT>\t exported clauses with a lower or equal " \
+         "LBD wake up a sharer, default is 1" << endl;
       cout << "\t-shr-lit=<INT>\t\t number of literals shared per round, " \
          "default is 1500" << endl;
+      cout << "\t-no-unit-channel\t share units through the sharers " \
+         "instead of the unit channel" << endl;
+      cout << "\t-no-shr-filter\t\t do not filter duplicate shared clauses" \
+         << endl;
+      cout << "\t-shr-filter-size=<INT>\t log2 of the number of buckets of " \
+         "the duplicate filter, default is 16 (4 MB)" << endl;
+      cout << "\t-shr-filter-window=<INT> time in seconds a shared clause is " \
+         "not shared again, default is 10" << endl;
+      cout << "\t-shr-score-lbd=<INT>\t weight of the LBD in the score of " \
+         "shared clauses, default is 4" << endl;
+      cout << "\t-shr-score-size=<INT>\t weight of the size in the score of " \
+         "shared clauses, default is 1" << endl;
+      cout << "\t-shr-score-age=<INT>\t weight of the age (in rounds) in the " \
+         "score of shared clauses, default is 2" << endl;
+      cout << "\t-shr-helpers=<INT>\t number of helper threads of a sharer " \
+         "processing its producers in parallel, default is 0" << endl;
+      cout << "\t-shr-log\t\t share clauses through a broadcast log read " \
+         "by the consumers" << endl;
+      cout << "\t-shr-log-lag=<INT>\t max number of clauses a consumer lags " \
+         "behind in the log before skipping the oldest ones, default is " \
+         "65536" << endl;
+      cout << "\t-reducers=<INT>\t\t number of strengthening workers, " \
+         "default is 2" << endl;
+      cout << "\t-reducer-solver=<STR>\t solver of the strengthening workers: " \
+         "m (MapleCOMSPS) or k (Kissat), default is m" << endl;
+      cout << "\t-reducer-chunk=<INT>\t number of clauses taken at once by " \
+         "a strengthening worker, default is 64" << endl;
+      cout << "\t-reducer-filter-size=<INT> log2 of the number of bits of a " \
+         "generation of the strengthened clauses filter, default is 25 (4 MB)" \
+         << endl;
+      cout << "\t-reducer-filter-hashes=<INT> number of bits set per clause in " \
+         "the strengthened clauses filter, default is 4" << endl;
+      cout << "\t-no-reducer-trail\t do not reuse the trail of the common " \
+         "assumptions between two strengthenings" << endl;
+      cout << "\t-reducer-wait=<INT>\t maximal time in useconds a reducer " \
+         "waits for clauses to strengthen, default is 100000" << endl;
+      cout << "\t-shr-strat=4\t\t also share clauses with the processes of " \
+         "the host through a shared memory segment" << endl;
+      cout << "\t-shm-name=<STR>\t\t name of the shared memory segment, " \
+         "default is /painless-<uid>-<hash of the formula>" << endl;
+      cout << "\t-shm-size=<INT>\t\t log2 of the number of clauses of the " \
+         "shared memory segment, default is 16 (16 MB)" << endl;
+      cout << "\t-mpi-lit=<INT>\t\t number of literals sent to the other " \
+         "processes per round (MPI runs), default is shr-lit" << endl;
+      cout << "\t-mpi-sleep=<INT>\t time in useconds between two exchanges " \
+         "with the other processes (MPI runs), default is shr-sleep" << endl;
+      cout << "\t-imp-cls-max=<INT>\t max number of clauses waiting to be " \
+         "imported by a solver, default is 0 (no limit), the log of " \
+         "shr-log is bounded by shr-log-lag" << endl;
+      cout << "\t-imp-unit-max=<INT>\t max number of units waiting to be " \
+         "imported by a solver, default is 0 (no limit)" << endl;
+      cout << "\t-imp-policy=<STR>\t policy when an import buffer is full: " \
+         "oldest, lbd or reject, default is oldest" << endl;
+      cout << "\t-wkr-strat=<INT>\t working strategy: 1 (portfolio) or 2 " \
+         "(divide and conquer, MapleCOMSPS only), default is 1" << endl;
+      cout << "\t-cubes=<INT>\t\t number of cubes generated by lookahead " \
+         "for the divide and conquer strategy, default is 0 (none)" << endl;
+      cout << "\t-cube-threads=<INT>\t number of threads of the cube " \
+         "generation, default is 4" << endl;
+      cout << "\t-cube-candidates=<INT> number of variables looked ahead per " \
+         "cube, default is 32" << endl;
+      cout << "\t-cube-file=<STR>\t write the formula and the cubes in " \
+         "iCNF format instead of solving" << endl;
+      cout << "\t-parse-threads=<INT>\t number of threads parsing the " \
+         "formula, default is the number of CPUs" << endl;
+      cout << "\t-compile-cnf=<STR>\t write the formula in the binary " \
+         "cache format, loaded without parsing, instead of solving" << endl;
+      cout << "\t-pin\t\t\t pin the solvers one per physical core and the " \
+         "sharers on the NUMA nodes of their producers" << endl;
       cout << "\t-v=<INT>\t\t verbosity level, default is 0" << endl;
+      MpiSharing::finish();
       return 0;
    }
 
@@ -87,6 +179,34 @@ int main(int argc, char ** argv)
    string solverName = Parameters::getParam("solver","m");
    setVerbosityLevel(Parameters::getIntParam("v", 0));
 
+   // Compile the formula in the binary cache format
+   string compiledFile = Parameters::getParam("compile-cnf", "");
+
+   if (compiledFile.empty() == false) {
+      const Formula & cnf = SolverFactory::getFormula();
+      bool saved          = cnf.save(compiledFile.c_str());
+
+      if (saved) {
+         cout << "c Formula compiled in " << compiledFile << ": "
+              << cnf.nVars << " variables, " << cnf.nClauses
+              << " clauses" << endl;
+      } else {
+         log(0, "Cannot write the formula in %s\n", compiledFile.c_str());
+      }
+
+      MpiSharing::finish();
+      return saved ? 0 : 1;
+   }
+
+   // Place the solvers and the sharers along the CPU topology
+   if (Parameters::getBoolParam("pin")) {
+      Topology::init();
+
+      log(1, "Topology: %d CPUs, %d physical cores, %d NUMA nodes\n",
+          Topology::getCpusCount(), Topology::getCoresCount(),
+          Topology::getNodesCount());
+   }
+
 
    // Create and init solvers
    vector<SolverInterface *> solvers;
@@ -99,13 +219,32 @@ int main(int argc, char ** argv)
    }
    else{
       SolverFactory::createMapleCOMSPSSolvers(cpus, solvers);
-      solvers.push_back(SolverFactory::createReducerSolver(SolverFactory::createMapleCOMSPSSolver()));
-      solvers.push_back(SolverFactory::createReducerSolver(SolverFactory::createMapleCOMSPSSolver()));
+   }
+
+   // The strengthening workers are gathered in a single reducer, Kissat
+   // runs use one only if its solver is given
+   int nCDCL            = solvers.size();
+   int nReducers        = Parameters::getIntParam("reducers", 2);
+   string reducerSolver = Parameters::getParam("reducer-solver", "");
+
+   if (nReducers > 0 &&
+       (solverName.compare("k") != 0 || reducerSolver.empty() == false))
+   {
+      if (reducerSolver.empty())
+         reducerSolver = "m";
+
+      solvers.push_back(SolverFactory::createReducerSolver(nReducers,
+                                                           reducerSolver));
    }
 
    int nSolvers = solvers.size();
 
-   SolverFactory::nativeDiversification(solvers);
+   // The processes of a MPI run diversify their solvers differently, the
+   // native offset keeps the parity of the ids
+   int rank = MpiSharing::getRank();
+
+   SolverFactory::nativeDiversification(solvers,
+                                        rank * (nSolvers + nSolvers % 2));
 
    for (int id = 0; id < nSolvers; id++) {
       if (id % 2) {
@@ -115,101 +254,240 @@ int main(int argc, char ** argv)
       }
    }
 
-   SolverFactory::sparseRandomDiversification(solvers_LRB);
-   SolverFactory::sparseRandomDiversification(solvers_VSIDS);
+   SolverFactory::sparseRandomDiversification(solvers_LRB, rank * nSolvers);
+   SolverFactory::sparseRandomDiversification(solvers_VSIDS, rank * nSolvers);
+
+   // Init the management of clauses, before any sharer or worker thread
+   // reads it
+   ClauseManager::initClauseManager();
+
+   if (Parameters::getBoolParam("no-unit-channel") == false) {
+      // Kissat only counts the variables it has seen, the formula is still
+      // loaded at this point
+      UnitChannel::init(SolverFactory::getFormula().nVars);
+   }
+
+   if (Parameters::getBoolParam("no-shr-filter") == false) {
+      ClauseFilter::init(Parameters::getIntParam("shr-filter-size", 16),
+                         Parameters::getIntParam("shr-filter-window", 10));
+   }
 
    // Init Sharing
-   // 15 CDCL, 1 Reducer producers by Sharer
-   vector<SolverInterface* > prod1;
-   vector<SolverInterface* > prod2;
-   vector<SolverInterface *> reducer1;
-   vector<SolverInterface *> reducer2;
+   // The CDCL solvers are split between two sharers
+   vector<SolverInterface *> cdcl(solvers.begin(), solvers.begin() + nCDCL);
+   vector<SolverInterface *> reducers(solvers.begin() + nCDCL, solvers.end());
+   vector<SolverInterface* > prod1(cdcl.begin(), cdcl.begin() + nCDCL/2);
+   vector<SolverInterface* > prod2(cdcl.begin() + nCDCL/2, cdcl.end());
    vector<SolverInterface* > cons1;
    vector<SolverInterface* > cons2;
-   vector<SolverInterface*> consCDCL;
+   ShmClauseRing * shmRing = NULL;
+   uint64_t shmKey;
+   char shmName[64];
 
    switch (Parameters::getIntParam("shr-strat", 1))
    {
    case 1:
-      prod1.insert(prod1.end(), solvers.begin(), solvers.begin() + (cpus/2 - 1));
-      prod1.push_back(solvers[solvers.size() - 2]);
-      prod2.insert(prod2.end(), solvers.begin() + (cpus/2 - 1), solvers.end() - 2);
-      prod2.push_back(solvers[solvers.size() - 1]);
-
-      cons1.insert(cons1.end(), solvers.begin(), solvers.end() - 1);
-      cons2.insert(cons2.end(), solvers.begin(), solvers.end() - 2);
-      cons2.push_back(solvers[solvers.size() - 1]);
+      prod1.insert(prod1.end(), reducers.begin(), reducers.end());
 
       nSharers = 2;
       sharers  = new Sharer*[nSharers];
-      sharers[0] = new Sharer(1, new HordeSatSharing(), prod1, cons1);
-      sharers[1] = new Sharer(2, new HordeSatSharing(), prod2, cons2);
+      sharers[0] = new Sharer(1, new HordeSatSharing(), prod1, solvers);
+      sharers[1] = new Sharer(2, new HordeSatSharing(), prod2, solvers);
       break;
    case 2:
-      prod1.insert(prod1.end(), solvers.begin(), solvers.begin() + (cpus/2 - 1));
-      prod2.insert(prod2.end(), solvers.begin() + (cpus/2 - 1), solvers.end() - 2);
-      reducer1.push_back(solvers[solvers.size() - 2]);
-      reducer2.push_back(solvers[solvers.size() - 1]);
-
       cons1.insert(cons1.end(), prod1.begin(), prod1.end());
-      cons1.push_back(solvers[solvers.size() - 2]);
+      cons1.insert(cons1.end(), reducers.begin(), reducers.end());
       cons2.insert(cons2.end(), prod2.begin(), prod2.end());
-      cons2.push_back(solvers[solvers.size() - 1]);
-      consCDCL.insert(consCDCL.end(), prod1.begin(), prod1.end());
-      consCDCL.insert(consCDCL.end(), prod2.begin(), prod2.end());
+      cons2.insert(cons2.end(), reducers.begin(), reducers.end());
 
-      nSharers = 4;
+      nSharers = reducers.empty() ? 2 : 3;
       sharers  = new Sharer*[nSharers];
       sharers[0] = new Sharer(1, new HordeSatSharing(), prod1, cons1);
       sharers[1] = new Sharer(2, new HordeSatSharing(), prod2, cons2);
-      sharers[2] = new Sharer(3, new HordeSatSharing(), reducer1, consCDCL);
-      sharers[3] = new Sharer(4, new HordeSatSharing(), reducer2, consCDCL);
+      if (reducers.empty() == false) {
+         sharers[2] = new Sharer(3, new HordeSatSharing(), reducers, cdcl);
+      }
       break;
    case 3:
-      prod1.insert(prod1.end(), solvers.begin(), solvers.begin() + cpus/2);
-      prod1.push_back(solvers[solvers.size() - 2]);
-      prod2.insert(prod2.end(), solvers.begin() + cpus/2, solvers.end() - 2);
-      prod2.push_back(solvers[solvers.size() - 1]);
+      prod1.insert(prod1.end(), reducers.begin(), reducers.end());
+
+      nSharers = 2;
+      sharers  = new Sharer*[nSharers];
+      sharers[0] = new Sharer(1, new StrengtheningSharing(), prod1, solvers);
+      sharers[1] = new Sharer(2, new StrengtheningSharing(), prod2, solvers);
+      break;
+   case 4:
+      prod1.insert(prod1.end(), reducers.begin(), reducers.end());
 
-      cons1.insert(cons1.end(), solvers.begin(), solvers.end() - 1);
-      cons2.insert(cons2.end(), solvers.begin(), solvers.end() - 2);
-      cons2.push_back(solvers[solvers.size() - 1]);
+      // The formula is identified by the hash of its clauses, by default
+      // only the processes of the user solving it share the segment
+      shmKey = SolverFactory::getFormula().getHash();
+
+      snprintf(shmName, sizeof(shmName), "/painless-%u-%016llx",
+               (unsigned)getuid(), (unsigned long long)shmKey);
+
+      shmRing = new ShmClauseRing(Parameters::getParam("shm-name", shmName),
+                                  Parameters::getIntParam("shm-size", 16),
+                                  shmKey);
 
       nSharers = 2;
       sharers  = new Sharer*[nSharers];
-      sharers[0] = new Sharer(1, new StrengtheningSharing(), prod1, cons1);
-      sharers[1] = new Sharer(2, new StrengtheningSharing(), prod2, cons2);
+
+      if (shmRing->isOpen()) {
+         sharers[0] = new Sharer(1, new ShmSharing(shmRing, true), prod1,
+                                 solvers);
+         sharers[1] = new Sharer(2, new ShmSharing(shmRing, false), prod2,
+                                 solvers);
+      } else {
+         sharers[0] = new Sharer(1, new HordeSatSharing(), prod1, solvers);
+         sharers[1] = new Sharer(2, new HordeSatSharing(), prod2, solvers);
+      }
       break;
    default:
       break;
    }
 
    // Init working
+   // With divide and conquer, the CDCL solvers solve cubes and the reducers
+   // stay in the portfolio
    working = new Portfolio();
+
+   DivideAndConquer * dc = NULL;
+
+   if (Parameters::getIntParam("wkr-strat", 1) == 2) {
+      bool cubing = true;
+
+      for (int i = 0; i < nCDCL; i++) {
+         cubing &= cdcl[i]->setCubing(true);
+      }
+
+      if (cubing) {
+         dc = new DivideAndConquer();
+         working->addSlave(dc);
+      } else {
+         for (int i = 0; i < nCDCL; i++) {
+            cdcl[i]->setCubing(false);
+         }
+         log(0, "The solvers cannot solve cubes, the portfolio is used\n");
+      }
+   }
+
    for (size_t i = 0; i < nSolvers; i++) {
-      working->addSlave(new SequentialWorker(solvers[i]));
+      if (dc != NULL && i < nCDCL) {
+         dc->addSlave(new SequentialWorker(solvers[i]));
+      } else {
+         working->addSlave(new SequentialWorker(solvers[i]));
+      }
    }
 
 
-   // Init the management of clauses
-   ClauseManager::initClauseManager();
+   // Generate the cubes of a cube and conquer run by lookahead, with
+   // dedicated MapleCOMSPS solvers
+   int nCubes      = Parameters::getIntParam("cubes", 0);
+   string cubeFile = Parameters::getParam("cube-file", "");
+   vector<int> cube;
+
+   if (nCubes > 0 && (dc != NULL || cubeFile.empty() == false)) {
+      vector<SolverInterface *> lookahead;
+      vector<vector<int> > cubes;
+
+      SolverFactory::createMapleCOMSPSSolvers(
+            Parameters::getIntParam("cube-threads", 4), lookahead);
+
+      CubeGenerator * generator = new CubeGenerator(lookahead,
+            Parameters::getIntParam("cube-candidates", 32));
+
+      generator->generate(cube, nCubes, cubes);
+
+      delete generator;
+
+      for (size_t i = 0; i < lookahead.size(); i++) {
+         lookahead[i]->release();
+      }
+
+      if (cubeFile.empty() == false) {
+         if (CubeGenerator::writeIcnf(SolverFactory::getFormula(),
+                                      cubeFile.c_str(), cubes) == false) {
+            log(0, "Cannot write the cubes in %s\n", cubeFile.c_str());
+         }
+
+         if (cubes.empty() == false) {
+            cout << "c " << cubes.size() << " cubes written in " << cubeFile
+                 << endl;
+            MpiSharing::finish();
+            return 0;
+         }
+      } else {
+         dc->setCubes(cubes);
+      }
+
+      // All the cubes are refuted
+      if (cubes.empty()) {
+         finalResult  = UNSAT;
+         globalEnding = true;
+      }
+   }
+
+
+   // All the solvers are created
+   SolverFactory::releaseFormula();
 
 
    // Launch working
-   vector<int> cube;
-   working->solve(cube);
+   if (globalEnding == false) {
+      working->solve(cube);
+   }
+
+   MpiSharing::start(solvers);
 
 
-   // Wait until end or timeout
+   // Wait until end or timeout, the strategies signal the end as soon as
+   // it is set
    int timeout = Parameters::getIntParam("t", -1);
 
    while(globalEnding == false) {
-      sleep(1);
+      if (timeout > 0) {
+         long remaining = (timeout - getRelativeTime()) * 1000000;
+
+         endingSignal.waitFor(max(remaining, 0L));
+      } else {
+         endingSignal.wait();
+      }
 
       if (timeout > 0 && getRelativeTime() >= timeout) {
          globalEnding = true;
          working->setInterrupt();
       }
+
+      // Opposite units have been learned
+      if (UnitChannel::hasConflict() && globalEnding == false) {
+         finalResult  = UNSAT;
+         globalEnding = true;
+         working->setInterrupt();
+      }
+   }
+
+   // The processes agree on the end and on the process printing the result
+   bool printResult = MpiSharing::finish();
+
+
+   // Print the result and the model if SAT, before the statistics
+   // cout << "c Resolution time: " << getRelativeTime() << "s" << endl;
+
+   if (printResult) {
+      if (finalResult == SAT) {
+         cout << "s SATISFIABLE" << endl;
+
+         if (Parameters::getBoolParam("no-model") == false) {
+            printModel(finalModel);
+         }
+      } else if (finalResult == UNSAT) {
+         cout << "s UNSATISFIABLE" << endl;
+      } else {
+         cout << "s UNKNOWN" << endl;
+      }
+
+      fflush(stdout);
    }
 
 
@@ -229,24 +507,39 @@ int main(int argc, char ** argv)
    // delete working;
 
 
-   // Delete shared clauses
-   ClauseManager::joinClauseManager();
+   // Print the export to import latencies of the shared clauses
+   LatencyHistogram latency;
 
+   for (size_t i = 0; i < solvers.size(); i++) {
+      latency.merge(solvers[i]->importLatency);
+   }
 
-   // Print the result and the model if SAT
-   // cout << "c Resolution time: " << getRelativeTime() << "s" << endl;
+   latency.print(1, "Import");
 
-   if (finalResult == SAT) {
-      cout << "s SATISFIABLE" << endl;
+   // Propagation throughput of the CDCL solvers
+   unsigned long propagations = 0;
 
-      if (Parameters::getBoolParam("no-model") == false) {
-         printModel(finalModel);
-      }
-   } else if (finalResult == UNSAT) {
-      cout << "s UNSATISFIABLE" << endl;
-   } else {
-      cout << "s UNKNOWN" << endl;
+   for (int i = 0; i < nCDCL; i++) {
+      propagations += solvers[i]->getStatistics().propagations;
+   }
+
+   log(1, "Propagations: %lu, %.0f per second\n", propagations,
+       propagations / getRelativeTime());
+
+   if (UnitChannel::isEnabled()) {
+      log(1, "Unit channel: %d units\n", UnitChannel::getUnitsCount());
    }
 
+   // The sharers may still write in the segment, it is only detached
+   if (shmRing != NULL && shmRing->isOpen()) {
+      log(1, "Shared memory: %lu clauses written, %lu skipped\n",
+          shmRing->getPushed(), shmRing->getLost());
+      shmRing->detach();
+   }
+
+
+   // Delete shared clauses
+   ClauseManager::joinClauseManager();
+
    return 0;
 }
@@ -21,6 +21,7 @@
 
 #include "sharing/Sharer.h"
 #include "solvers/SolverInterface.h"
+#include "utils/Threading.h"
 #include "working/WorkingStrategy.h"
 
 #include <atomic>
@@ -31,6 +32,9 @@ using namespace std;
 /// Is it the end of the search
 extern atomic<bool> globalEnding;
 
+/// Signaled to wake up the main thread once the end of the search is set
+extern Condition endingSignal;
+
 /// Working strategy
 extern WorkingStrategy * working;
 
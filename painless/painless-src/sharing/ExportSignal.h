@@ -0,0 +1,78 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../clauses/ClauseExchange.h"
+#include "../utils/Threading.h"
+
+#include <atomic>
+
+using namespace std;
+
+/// Signal used by the producers of a sharer to wake it up.
+/// Producers notify it when they have exported enough literals or a clause
+/// of high value, or as soon as they export if the sharer is idle.
+class ExportSignal
+{
+public:
+   /// Constructor.
+   ExportSignal(int wakeLiterals, int wakeLbd)
+   {
+      this->wakeLiterals = wakeLiterals;
+      this->wakeLbd      = wakeLbd;
+      this->idle         = false;
+      this->pending      = false;
+   }
+
+   /// Wake up the sharer, only the first notification takes the lock.
+   void notify()
+   {
+      if (pending.exchange(true) == false) {
+         idle = false;
+         cond.signal();
+      }
+   }
+
+   /// Wait for a notification at most a given time in microseconds.
+   /// @return true if notified, false if the time is elapsed.
+   bool wait(long usec)
+   {
+      // Cleared before waiting, so a notification during the wait signals
+      // the condition, an earlier one is kept by the condition
+      pending.exchange(false);
+      return cond.waitFor(usec);
+   }
+
+   /// Number of exported literals before waking up the sharer.
+   int wakeLiterals;
+
+   /// Clauses with a LBD lower or equal to this value wake up the sharer.
+   int wakeLbd;
+
+   /// Is the sharer idle (no clause during the last round).
+   atomic<bool> idle;
+
+protected:
+   /// Is a notification pending.
+   atomic<bool> pending;
+
+   /// Condition the sharer waits on.
+   Condition cond;
+};
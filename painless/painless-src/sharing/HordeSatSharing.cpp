@@ -17,18 +17,36 @@
 // this program.  If not, see <http://www.gnu.org/licenses/>.
 // -----------------------------------------------------------------------------
 
+#include "../clauses/ClauseFilter.h"
 #include "../clauses/ClauseManager.h"
+#include "../sharing/MpiSharing.h"
 #include "../sharing/HordeSatSharing.h"
 #include "../solvers/SolverFactory.h"
 #include "../utils/Logger.h"
 #include "../utils/Parameters.h"
+#include "../utils/System.h"
+
+#include <algorithm>
 
 HordeSatSharing::HordeSatSharing()
 {
    this->literalPerRound = Parameters::getIntParam("shr-lit", 1500);
+   this->roundDuration   = Parameters::getIntParam("shr-sleep", 500000) / 1e6;
+   this->lastRound       = getRelativeTime();
    this->initPhase = true;
-   // number of round corresponding to 5% of the 5000s timeout
-   this->roundBeforeIncrease = 250000000 / Parameters::getIntParam("shr-sleep", 500000);
+   // The init phase lasts 5% of the 5000s timeout, whatever the number of
+   // rounds triggered by the producers
+   this->initPhaseEnd = this->lastRound + 250;
+   this->filterGroup  = 0;
+   this->clauseLog = NULL;
+
+   // The lag of a consumer in the log is always bounded, unlike its import
+   // buffer
+   if (Parameters::getBoolParam("shr-log")) {
+      this->clauseLog = new ClauseLog(Parameters::getIntParam("shr-log-lag",
+                                                              LOG_MAX_LAG));
+   }
+   this->pool      = new ThreadPool(Parameters::getIntParam("shr-helpers", 0));
 }
 
 HordeSatSharing::~HordeSatSharing()
@@ -36,75 +54,209 @@ HordeSatSharing::~HordeSatSharing()
     for (auto pair : this->databases) {
         delete pair.second;
     }
+
+    if (this->clauseLog != NULL) {
+        delete this->clauseLog;
+    }
+
+    delete this->pool;
 }
 
 void
 HordeSatSharing::doSharing(int idSharer, const vector<SolverInterface *> & from,
                            const vector<SolverInterface *> & to)
 {
-   static unsigned int round = 1;
-   // vector<ClauseExchange*> cls_to_reduce;
-   // vector<ClauseExchange*> cls_to_send;
+   // Rounds are triggered by the producers, so the literal budget follows
+   // the duration of the round
+   double now   = getRelativeTime();
+   double ratio = (now - this->lastRound) / this->roundDuration;
+   int budget   = literalPerRound * max(0.1, min(ratio, 2.0));
+
+   this->lastRound   = now;
+   this->filterGroup = ClauseFilter::getGroup(to);
+
+   if (this->clauseLog != NULL) {
+      for (size_t j = 0; j < to.size(); j++) {
+         if (this->knownConsumers.insert(to[j]->id).second &&
+             to[j]->subscribeClauseLog(this->clauseLog))
+         {
+            this->logConsumers.insert(to[j]->id);
+         }
+      }
+   }
+
+   // The map is only accessed here, the tasks get the database of their
+   // producer
+   vector<ClauseDatabase *> producerDatabases(from.size());
+
+   for (size_t i = 0; i < from.size(); i++) {
+      if (!this->databases.count(from[i]->id)) {
+          this->databases[from[i]->id] = new ClauseDatabase(literalPerRound);
+      }
+
+      producerDatabases[i] = this->databases[from[i]->id];
+   }
+
+   // Producers are processed in parallel, each task only touches the
+   // database of its producer and its own result
+   rounds.clear();
+   rounds.resize(from.size());
+
+   pool->parallelFor(from.size(), [&](int i) {
+      shareProducer(idSharer, from[i], producerDatabases[i], to, budget,
+                    rounds[i]);
+   });
+
    for (size_t i = 0; i < from.size(); i++) {
-      int used, usedPercent, selectCount;
-      int id = from[i]->id;
+      ProducerRound & result = rounds[i];
+      int id                 = from[i]->id;
 
-      if (!this->databases.count(id)) {
-          this->databases[id] = new ClauseDatabase();
+      if (this->clauseLog != NULL) {
+         broadcast(id, to, result);
       }
 
-      tmp.clear();
-      // cls_to_reduce.clear();
-      // cls_to_send.clear();
+      stats.receivedClauses        += result.received;
+      stats.sharedClauses          += result.selection.size();
+      stats.droppedClauses         += result.dropped;
+      stats.duplicateClauses       += result.duplicates;
+      stats.producerClauses[id]    += result.selection.size() +
+                                      result.duplicates;
+      stats.producerDuplicates[id] += result.duplicates;
+
+      if (result.filled) {
+         this->initPhase = false;
+      }
+   }
+
+   if (now >= this->initPhaseEnd) {
+      this->initPhase = false;
+   }
+
+   if (this->clauseLog != NULL) {
+      stats.droppedClauses += this->clauseLog->reclaim();
+   }
+}
+
+void
+HordeSatSharing::shareProducer(int idSharer, SolverInterface * producer,
+                               ClauseDatabase * database,
+                               const vector<SolverInterface *> & to,
+                               int budget, ProducerRound & result)
+{
+   int used, usedPercent, selectCount;
+   int id = producer->id;
+
+   vector<ClauseExchange *> & tmp = result.selection;
 
-      from[i]->getLearnedClauses(tmp);
+   producer->getLearnedClauses(tmp);
 
-      stats.receivedClauses += tmp.size();
+   result.received = tmp.size();
+
+   for (size_t k = 0; k < tmp.size(); k++) {
+      database->addClause(tmp[k]);
+   }
+
+   tmp.clear();
+
+   used        = database->giveSelection(tmp, budget, &selectCount);
+   usedPercent = (100 * used) / budget;
+
+   if (tmp.size() > 0) {
+      double sumLbd = 0;
 
       for (size_t k = 0; k < tmp.size(); k++) {
-         this->databases[id]->addClause(tmp[k]);
+         sumLbd += tmp[k]->lbd;
       }
 
-      tmp.clear();
+      log(2, "Sharer %d selected %d clauses of solver %d, average lbd " \
+          "%.2f, database capacity %d literals\n", idSharer, selectCount,
+          id, sumLbd / tmp.size(), database->getCapacity());
+   }
+
+   result.duplicates = ClauseFilter::removeDuplicates(tmp, this->filterGroup);
 
-      used        = this->databases[id]->giveSelection(tmp, literalPerRound, &selectCount);
-      usedPercent = (100 * used) / literalPerRound;
+   // The selection is also sent to the other processes, if any
+   MpiSharing::send(tmp);
+   publish(tmp);
 
-      stats.sharedClauses += tmp.size();
+   if (usedPercent < 75 && !this->initPhase) {
+      producer->increaseClauseProduction();
+      log(2, "Sharer %d production increase for solver %d.\n", idSharer,
+          producer->id);
+   } else if (usedPercent > 98) {
+      producer->decreaseClauseProduction();
+      log(2, "Sharer %d production decrease for solver %d.\n", idSharer,
+          producer->id);
+   }
 
-      if (usedPercent < 75 && !this->initPhase) {
-         from[i]->increaseClauseProduction();
-         log(2, "Sharer %d production increase for solver %d.\n", idSharer,
-             from[i]->id);
-      } else if (usedPercent > 98) {
-         from[i]->decreaseClauseProduction();
-         log(2, "Sharer %d production decrease for solver %d.\n", idSharer,
-             from[i]->id);
+   if (selectCount > 0) {
+      log(2, "Sharer %d filled %d%% of its buffer %.2f\n", idSharer,
+          usedPercent, used/(float)selectCount);
+      result.filled = true;
+   }
+
+   // With a log, the selection is broadcast by the sharer thread
+   if (this->clauseLog != NULL)
+      return;
+
+   for (size_t j = 0; j < to.size(); j++) {
+      if (producer->id != to[j]->id) {
+         for (size_t k = 0; k < tmp.size(); k++) {
+            ClauseManager::increaseClause(tmp[k], 1);
+         }
+         result.dropped += to[j]->addLearnedClauses(tmp);
       }
+   }
 
-      if (selectCount > 0) {
-         log(2, "Sharer %d filled %d%% of its buffer %.2f\n", idSharer,
-             usedPercent, used/(float)selectCount);
-         this->initPhase = false;
+   for (size_t k = 0; k < tmp.size(); k++) {
+      ClauseManager::releaseClause(tmp[k]);
+   }
+}
+
+void
+HordeSatSharing::publish(const vector<ClauseExchange *> & selection)
+{
+}
+
+void
+HordeSatSharing::broadcast(int producer, const vector<SolverInterface *> & to,
+                           ProducerRound & result)
+{
+   vector<ClauseExchange *> clauses;
+   vector<ClauseExchange *> units;
+
+   // Units are imported through the unit buffers of the solvers
+   for (size_t k = 0; k < result.selection.size(); k++) {
+      if (result.selection[k]->size == 1) {
+         units.push_back(result.selection[k]);
+      } else {
+         clauses.push_back(result.selection[k]);
       }
-      if (round >= this->roundBeforeIncrease) {
-         this->initPhase = false;
+   }
+
+   for (size_t j = 0; j < to.size(); j++) {
+      if (producer == to[j]->id)
+         continue;
+
+      for (size_t k = 0; k < units.size(); k++) {
+         ClauseManager::increaseClause(units[k], 1);
       }
+      result.dropped += to[j]->addLearnedClauses(units);
 
-      for (size_t j = 0; j < to.size(); j++) {
-         if (from[i]->id != to[j]->id) {
-            for (size_t k = 0; k < tmp.size(); k++) {
-               ClauseManager::increaseClause(tmp[k], 1);
-            }
-            to[j]->addLearnedClauses(tmp);
+      if (this->logConsumers.count(to[j]->id) == 0) {
+         for (size_t k = 0; k < clauses.size(); k++) {
+            ClauseManager::increaseClause(clauses[k], 1);
          }
+         result.dropped += to[j]->addLearnedClauses(clauses);
       }
+   }
 
-      for (size_t k = 0; k < tmp.size(); k++) {
-         ClauseManager::releaseClause(tmp[k]);
-      }
+   for (size_t k = 0; k < units.size(); k++) {
+      ClauseManager::releaseClause(units[k]);
    }
-   round++;
+
+   // The log takes the references of the selected clauses
+   this->clauseLog->append(clauses, producer);
 }
 
 SharingStatistics
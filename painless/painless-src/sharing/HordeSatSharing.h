@@ -20,10 +20,13 @@
 #pragma once
 
 #include "../clauses/ClauseDatabase.h"
+#include "../clauses/ClauseLog.h"
 #include "../sharing/SharingStrategy.h"
 #include "../solvers/SolverInterface.h"
+#include "../utils/ThreadPool.h"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 /// This strategy is a hordesat like sharing strategy.
@@ -44,14 +47,37 @@ public:
    SharingStatistics getStatistics();
 
 protected:
+   /// Select the clauses of a producer and push them to the consumers if
+   /// there is no broadcast log, may run in a helper thread.
+   void shareProducer(int idSharer, SolverInterface * producer,
+                      ClauseDatabase * database,
+                      const vector<SolverInterface *> & to, int budget,
+                      ProducerRound & result);
+
+   /// Hand the selection of a producer to another transport, nothing by
+   /// default, may run in a helper thread.
+   virtual void publish(const vector<ClauseExchange *> & selection);
+
+   /// Append the selection of a producer to the broadcast log, units and
+   /// clauses for consumers not reading the log are pushed.
+   void broadcast(int producer, const vector<SolverInterface *> & to,
+                  ProducerRound & result);
+
    /// Number of shared literals per round.
    int literalPerRound;
 
+   /// Expected duration of a round in seconds.
+   double roundDuration;
+
+   /// Time of the previous round.
+   double lastRound;
+
    /// Are we in init phase.
    bool initPhase;
 
-   /// Number of round before forcing an increase in production
-   int roundBeforeIncrease;
+   /// Time in seconds at which the init phase ends, production increases
+   /// are then forced.
+   double initPhaseEnd;
 
    /// Databse used to store the clauses.
    unordered_map<int, ClauseDatabase *> databases;
@@ -59,6 +85,22 @@ protected:
    /// Sharing statistics.
    SharingStatistics stats;
 
-   /// Used to manipulate clauses.
-   vector<ClauseExchange *> tmp;
+   /// Key of the consumers in the duplicate filter.
+   uint64_t filterGroup;
+
+   /// Work of the current round, one per producer.
+   vector<ProducerRound> rounds;
+
+   /// Helper threads processing the producers.
+   ThreadPool * pool;
+
+   /// Broadcast log of the shared clauses, NULL if clauses are pushed in the
+   /// buffers of the consumers.
+   ClauseLog * clauseLog;
+
+   /// Consumers reading the broadcast log.
+   unordered_set<int> logConsumers;
+
+   /// Consumers already asked to subscribe to the log.
+   unordered_set<int> knownConsumers;
 };
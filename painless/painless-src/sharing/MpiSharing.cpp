@@ -0,0 +1,321 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/ClauseFilter.h"
+#include "../clauses/ClauseManager.h"
+#include "../clauses/UnitChannel.h"
+#include "../painless.h"
+#include "../sharing/MpiSharing.h"
+#include "../utils/Logger.h"
+#include "../utils/Parameters.h"
+
+#include <algorithm>
+#include <unistd.h>
+#include <unordered_set>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+using namespace std;
+
+/// State of a process sent with its clauses, the other states are the
+/// results SAT and UNSAT.
+#define MPI_STATE_RUNNING 0
+#define MPI_STATE_ENDED   1
+
+int                        MpiSharing::rank            = 0;
+int                        MpiSharing::size            = 1;
+bool                       MpiSharing::enabled         = false;
+bool                       MpiSharing::reporter        = true;
+vector<SolverInterface *>  MpiSharing::consumers;
+ClauseBuffer               MpiSharing::outbox;
+Thread *                   MpiSharing::thread          = NULL;
+int                        MpiSharing::literalPerRound = 1500;
+int                        MpiSharing::sleepTime       = 500000;
+unsigned long              MpiSharing::sent            = 0;
+unsigned long              MpiSharing::received        = 0;
+unsigned long              MpiSharing::duplicates      = 0;
+
+void
+MpiSharing::init(int * argc, char *** argv)
+{
+#ifdef USE_MPI
+   int provided;
+
+   // The main thread calls MPI before and after the communication thread,
+   // never at the same time
+   MPI_Init_thread(argc, argv, MPI_THREAD_SERIALIZED, &provided);
+   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+   MPI_Comm_size(MPI_COMM_WORLD, &size);
+#endif
+}
+
+void
+MpiSharing::start(const vector<SolverInterface *> & consumers)
+{
+   if (size <= 1)
+      return;
+
+   int shrLit   = Parameters::getIntParam("shr-lit", 1500);
+   int shrSleep = Parameters::getIntParam("shr-sleep", 500000);
+
+   MpiSharing::consumers       = consumers;
+   MpiSharing::literalPerRound = Parameters::getIntParam("mpi-lit", shrLit);
+   MpiSharing::sleepTime       = Parameters::getIntParam("mpi-sleep", shrSleep);
+   MpiSharing::enabled         = true;
+   MpiSharing::thread          = new Thread(MpiSharing::main, NULL);
+
+   log(1, "Process %d of %d shares clauses through MPI\n", rank, size);
+}
+
+bool
+MpiSharing::finish()
+{
+   if (enabled) {
+      thread->join();
+      delete thread;
+
+      log(1, "Process %d sent %lu clauses, received %lu clauses, %lu " \
+          "duplicates\n", rank, sent, received, duplicates);
+
+      // The clauses not sent are released
+      ClauseExchange * cls;
+
+      while (outbox.getClause(&cls)) {
+         ClauseManager::releaseClause(cls);
+      }
+   }
+
+#ifdef USE_MPI
+   MPI_Finalize();
+#endif
+
+   return reporter;
+}
+
+bool
+MpiSharing::isEnabled()
+{
+   return enabled;
+}
+
+void
+MpiSharing::send(const vector<ClauseExchange *> & clauses)
+{
+   if (enabled == false)
+      return;
+
+   for (size_t i = 0; i < clauses.size(); i++) {
+      ClauseManager::increaseClause(clauses[i], 1);
+      outbox.addClause(clauses[i]);
+   }
+}
+
+int
+MpiSharing::getRank()
+{
+   return rank;
+}
+
+int
+MpiSharing::getSize()
+{
+   return size;
+}
+
+void *
+MpiSharing::main(void * arg)
+{
+   while (true) {
+      usleep(sleepTime);
+
+      if (exchange())
+         break;
+   }
+
+   return NULL;
+}
+
+bool
+MpiSharing::exchange()
+{
+#ifdef USE_MPI
+   static int unitCursor = 0;
+
+   // Units received from the other processes, they already know them
+   static unordered_set<int> remoteUnits;
+
+   vector<ClauseExchange *> clauses;
+   vector<int> message;
+   int lit;
+
+   // The state is read before the clauses, the result is written before
+   // globalEnding by the winner
+   if (globalEnding == false) {
+      message.push_back(MPI_STATE_RUNNING);
+   } else if (finalResult == SAT || finalResult == UNSAT) {
+      message.push_back(finalResult);
+   } else {
+      message.push_back(MPI_STATE_ENDED);
+   }
+
+   // The local units of the unit channel are all sent, once
+   while (UnitChannel::nextUnit(unitCursor, &lit)) {
+      if (remoteUnits.count(lit))
+         continue;
+
+      message.push_back(1);
+      message.push_back(1);
+      message.push_back(lit);
+      sent++;
+   }
+
+   // The other clauses are sent by increasing LBD within the budget, a
+   // message is [state, (size, lbd, lits)*]
+   outbox.getClauses(clauses);
+
+   stable_sort(clauses.begin(), clauses.end(),
+               [](ClauseExchange * a, ClauseExchange * b) {
+                  return a->lbd < b->lbd;
+               });
+
+   int used = 0;
+
+   for (size_t i = 0; i < clauses.size(); i++) {
+      ClauseExchange * cls = clauses[i];
+
+      if (used + cls->size <= literalPerRound) {
+         message.push_back(cls->size);
+         message.push_back(cls->lbd);
+         message.insert(message.end(), cls->lits, cls->lits + cls->size);
+         used += cls->size;
+         sent++;
+      }
+
+      ClauseManager::releaseClause(cls);
+   }
+
+   // Gather the messages of all the processes
+   int count = message.size();
+   vector<int> counts(size);
+   vector<int> displs(size);
+
+   MPI_Allgather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT,
+                 MPI_COMM_WORLD);
+
+   int total = 0;
+
+   for (int r = 0; r < size; r++) {
+      displs[r] = total;
+      total    += counts[r];
+   }
+
+   vector<int> all(total);
+
+   MPI_Allgatherv(message.data(), count, MPI_INT, all.data(), counts.data(),
+                  displs.data(), MPI_INT, MPI_COMM_WORLD);
+
+   // Decode the states and the remote clauses
+   vector<ClauseExchange *> remote;
+   bool ended = false;
+   int winner = -1;
+
+   for (int r = 0; r < size; r++) {
+      const int * msg = all.data() + displs[r];
+
+      if (msg[0] != MPI_STATE_RUNNING) {
+         ended = true;
+
+         if (msg[0] != MPI_STATE_ENDED && winner < 0)
+            winner = r;
+      }
+
+      if (r == rank)
+         continue;
+
+      int pos = 1;
+
+      while (pos < counts[r]) {
+         int clsSize          = msg[pos];
+         ClauseExchange * cls = ClauseManager::allocClause(clsSize);
+
+         cls->lbd  = msg[pos + 1];
+         cls->from = -1;
+
+         copy(msg + pos + 2, msg + pos + 2 + clsSize, cls->lits);
+         remote.push_back(cls);
+
+         pos += clsSize + 2;
+      }
+   }
+
+   received += remote.size();
+
+   // Every process takes the same decision, the lowest rank with a result
+   // prints it, rank 0 prints UNKNOWN if there is none
+   if (ended) {
+      for (size_t i = 0; i < remote.size(); i++) {
+         ClauseManager::releaseClause(remote[i]);
+      }
+
+      reporter = winner == rank || (winner < 0 && rank == 0);
+
+      if (globalEnding == false) {
+         globalEnding = true;
+         working->setInterrupt();
+         endingSignal.signal();
+      }
+
+      return true;
+   }
+
+   uint64_t group = ClauseFilter::getGroup(consumers);
+
+   duplicates += ClauseFilter::removeDuplicates(remote, group);
+
+   // Units go to the unit channel if any, the other clauses to the consumers
+   vector<ClauseExchange *> toConsumers;
+
+   for (size_t i = 0; i < remote.size(); i++) {
+      if (remote[i]->size == 1 && UnitChannel::isEnabled()) {
+         remoteUnits.insert(remote[i]->lits[0]);
+         UnitChannel::addUnit(remote[i]->lits[0]);
+         ClauseManager::releaseClause(remote[i]);
+      } else {
+         toConsumers.push_back(remote[i]);
+      }
+   }
+
+   for (size_t j = 0; j < consumers.size(); j++) {
+      for (size_t k = 0; k < toConsumers.size(); k++) {
+         ClauseManager::increaseClause(toConsumers[k], 1);
+      }
+      consumers[j]->addLearnedClauses(toConsumers);
+   }
+
+   for (size_t k = 0; k < toConsumers.size(); k++) {
+      ClauseManager::releaseClause(toConsumers[k]);
+   }
+
+   return false;
+#else
+   return true;
+#endif
+}
@@ -0,0 +1,101 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../clauses/ClauseBuffer.h"
+#include "../solvers/SolverInterface.h"
+#include "../utils/Threading.h"
+
+#include <vector>
+
+using namespace std;
+
+/// Process-wide clause sharing between painless processes, through MPI.
+/// The clauses selected by the sharers of a process are sent to the other
+/// processes in a single message per round, all the messages being gathered
+/// by every process (all-gather). A message also carries the state of its
+/// process, so all the processes stop once one of them has ended. Without
+/// USE_MPI, or with a single process, the sharing is disabled.
+class MpiSharing
+{
+public:
+   /// Init MPI, must be called by the main thread before any other thread
+   /// is started.
+   static void init(int * argc, char *** argv);
+
+   /// Start the communication thread if there are several processes, the
+   /// remote clauses are given to the consumers.
+   static void start(const vector<SolverInterface *> & consumers);
+
+   /// Wait for the end of the communication thread and finalize MPI,
+   /// return true if this process has to print the result.
+   static bool finish();
+
+   /// Is the sharing between processes enabled.
+   static bool isEnabled();
+
+   /// Send clauses to the other processes, the references of the caller
+   /// are kept.
+   static void send(const vector<ClauseExchange *> & clauses);
+
+   /// Return the rank of this process, 0 without MPI.
+   static int getRank();
+
+   /// Return the number of processes, 1 without MPI.
+   static int getSize();
+
+protected:
+   /// Main of the communication thread.
+   static void * main(void * arg);
+
+   /// Exchange the clauses and states of the processes, return true if the
+   /// processes have to stop.
+   static bool exchange();
+
+   /// Rank of this process and number of processes.
+   static int rank;
+   static int size;
+
+   /// Is the sharing enabled.
+   static bool enabled;
+
+   /// Does this process print the result.
+   static bool reporter;
+
+   /// Consumers of the remote clauses.
+   static vector<SolverInterface *> consumers;
+
+   /// Clauses waiting to be sent.
+   static ClauseBuffer outbox;
+
+   /// Communication thread.
+   static Thread * thread;
+
+   /// Number of literals sent per round.
+   static int literalPerRound;
+
+   /// Time in useconds between two rounds.
+   static int sleepTime;
+
+   /// Number of sent, received and duplicate remote clauses.
+   static unsigned long sent;
+   static unsigned long received;
+   static unsigned long duplicates;
+};
@@ -22,6 +22,8 @@
 #include "../solvers/SolverInterface.h"
 #include "../utils/Logger.h"
 #include "../utils/Parameters.h"
+#include "../utils/System.h"
+#include "../utils/Topology.h"
 
 #include <algorithm>
 #include <unistd.h>
@@ -35,19 +37,53 @@ static void * mainThrSharing(void * arg)
    Sharer * shr  = (Sharer *)arg;
    int round     = 0;
    int sleepTime = Parameters::getIntParam("shr-sleep", 500000);
+   int minSleep  = Parameters::getIntParam("shr-min-sleep", sleepTime / 10);
+   int maxSleep  = Parameters::getIntParam("shr-max-sleep", sleepTime * 4);
+   int timeout   = sleepTime;
+
+   double lastRound        = getRelativeTime();
+   unsigned long lastCount = 0;
+
+   // The sharer runs on the nodes of its producers, where their exported
+   // clauses are
+   if (Topology::isEnabled()) {
+      vector<int> ids;
+
+      for (size_t i = 0; i < shr->producers.size(); i++) {
+         ids.push_back(shr->producers[i]->id);
+      }
+
+      Topology::pinNear(ids);
+   }
 
    while (true) {
-      // Sleep 
-      usleep(sleepTime);
+      // Wait for the producers or the end of the round
+      bool notified = shr->signal->wait(timeout);
    
       if (globalEnding)
          break; // Need to stop
 
+      // Keep a minimal interval between two rounds
+      long elapsed = (getRelativeTime() - lastRound) * 1000000;
+
+      if (elapsed < minSleep)
+         usleep(minSleep - elapsed);
+
+      lastRound = getRelativeTime();
+
       round++; // New round
 
       SharingStatistics stats = shr->sharingStrategy->getStatistics();
-      log(1, "Sharer %d enter in round  %d, received cls %ld, shared cls %ld\n",
-          shr->id, round, stats.receivedClauses, stats.sharedClauses);
+      log(1, "Sharer %d enter in round  %d (%s), received cls %ld, shared " \
+          "cls %ld, dropped cls %ld, duplicate cls %ld\n", shr->id, round,
+          notified ? "signal" : "timeout", stats.receivedClauses,
+          stats.sharedClauses, stats.droppedClauses, stats.duplicateClauses);
+
+      for (auto pair : stats.producerClauses) {
+         log(2, "Sharer %d solver %d duplicate rate %.2f%%\n", shr->id,
+             pair.first, pair.second == 0 ? 0 :
+             100.0 * stats.producerDuplicates[pair.first] / pair.second);
+      }
 
 
       // Add new solvers
@@ -66,8 +102,26 @@ static void * mainThrSharing(void * arg)
 
 
       // Sharing phase
+      double roundStart = getRelativeTime();
+
       shr->sharingStrategy->doSharing(shr->id, shr->producers, shr->consumers);
 
+      log(2, "Sharer %d round %d done in %.3f ms\n", shr->id, round,
+          (getRelativeTime() - roundStart) * 1000);
+
+      // Sleep longer when nothing is exported, the first export wakes us up
+      unsigned long count = shr->sharingStrategy->getStatistics().receivedClauses;
+
+      if (count == lastCount) {
+         timeout = min(2 * timeout, maxSleep);
+         shr->signal->idle = true;
+      } else {
+         timeout = sleepTime;
+         shr->signal->idle = false;
+      }
+
+      lastCount = count;
+
       
       // Remove solvers
       // -------------------------
@@ -109,9 +163,14 @@ Sharer::Sharer(int id, SharingStrategy * sharingStrategy,
    this->sharingStrategy = sharingStrategy;
    this->producers       = producers;
    this->consumers       = consumers;
+   this->signal          = new ExportSignal(
+                              Parameters::getIntParam("shr-wake-lit",
+                                 Parameters::getIntParam("shr-lit", 1500)),
+                              Parameters::getIntParam("shr-wake-lbd", 1));
 
    for (size_t i = 0; i < producers.size(); i++) {
       producers[i]->increase();
+      producers[i]->setExportSignal(signal);
    }
 
    for (size_t i = 0; i < consumers.size(); i++) {
@@ -139,12 +198,14 @@ Sharer::~Sharer()
    removeLock.unlock();
 
    delete sharingStrategy;
+   delete signal;
 }
 
 void
 Sharer::addProducer(SolverInterface * solver)
 {
    solver->increase();
+   solver->setExportSignal(signal);
 
    addLock.lock();
    addProducers.push_back(solver);
@@ -183,5 +244,16 @@ Sharer::printStats()
    SharingStatistics stats = sharingStrategy->getStatistics();
 
    cout << "c Sharer " << id << " received cls "<< stats.receivedClauses
-        << ", shared cls " << stats.sharedClauses << endl;
+        << ", shared cls " << stats.sharedClauses << ", dropped cls "
+        << stats.droppedClauses << ", duplicate cls "
+        << stats.duplicateClauses << endl;
+
+   for (auto pair : stats.producerClauses) {
+      unsigned long duplicates = stats.producerDuplicates[pair.first];
+
+      cout << "c Sharer " << id << " solver " << pair.first
+           << " duplicate rate " << (pair.second == 0 ? 0 :
+                                     100.0 * duplicates / pair.second)
+           << "% (" << duplicates << "/" << pair.second << ")" << endl;
+   }
 }
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "../sharing/ExportSignal.h"
 #include "../sharing/SharingStrategy.h"
 #include "../utils/Threading.h"
 
@@ -86,6 +87,9 @@ protected:
    /// Vector of the consumers.
    vector<SolverInterface *> consumers;
    
+   /// Signal used by the producers to wake up the sharer.
+   ExportSignal * signal;
+
    /// Pointer to the thread in chrage of sharing.
    Thread * sharer;
 };
@@ -21,6 +21,7 @@
 
 #include "../solvers/SolverInterface.h"
 
+#include <map>
 #include <vector>
 
 using namespace std;
@@ -33,6 +34,8 @@ struct SharingStatistics
    {
       sharedClauses   = 0;
       receivedClauses = 0;
+      droppedClauses  = 0;
+      duplicateClauses = 0;
    }
 
    /// Number of shared clauses that have been shared.
@@ -40,9 +43,51 @@ struct SharingStatistics
 
    /// Number of shared clauses produced.
    unsigned long receivedClauses;
+
+   /// Number of shared clauses dropped or rejected by the import buffers of
+   /// the consumers.
+   unsigned long droppedClauses;
+
+   /// Number of selected clauses removed by the duplicate filter.
+   unsigned long duplicateClauses;
+
+   /// Number of selected clauses checked by the filter, per producer.
+   map<int, unsigned long> producerClauses;
+
+   /// Number of duplicates, per producer.
+   map<int, unsigned long> producerDuplicates;
 };
 
 /// Strategy to shared clauses.
+/// Work of a sharing round for one producer, filled by the task processing
+/// the producer and merged in the statistics by the sharer.
+struct ProducerRound
+{
+   /// Constructor.
+   ProducerRound()
+   {
+      received   = 0;
+      dropped    = 0;
+      duplicates = 0;
+      filled     = false;
+   }
+
+   /// Clauses selected for the consumers.
+   vector<ClauseExchange *> selection;
+
+   /// Number of clauses received from the producer.
+   unsigned long received;
+
+   /// Number of clauses dropped by the consumers.
+   unsigned long dropped;
+
+   /// Number of selected clauses removed by the duplicate filter.
+   unsigned long duplicates;
+
+   /// Has at least one clause been selected.
+   bool filled;
+};
+
 class SharingStrategy
 {
 public:
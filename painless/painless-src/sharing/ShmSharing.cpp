@@ -0,0 +1,104 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/ClauseFilter.h"
+#include "../clauses/ClauseManager.h"
+#include "../clauses/UnitChannel.h"
+#include "../sharing/ShmSharing.h"
+#include "../utils/Logger.h"
+
+ShmSharing::ShmSharing(ShmClauseRing * ring, bool importer)
+{
+   this->ring       = ring;
+   this->importer   = importer;
+   this->cursor     = ring->getCursor();
+   this->unitCursor = 0;
+}
+
+void
+ShmSharing::doSharing(int idSharer, const vector<SolverInterface *> & from,
+                      const vector<SolverInterface *> & to)
+{
+   HordeSatSharing::doSharing(idSharer, from, to);
+
+   if (importer == false)
+      return;
+
+   // The units of the unit channel do not go through the sharers
+   ClauseExchange * unit = ClauseManager::allocClause(1);
+   int lit;
+
+   unit->lbd = 1;
+
+   while (UnitChannel::nextUnit(unitCursor, &lit)) {
+      if (remoteUnits.count(lit))
+         continue;
+
+      unit->lits[0] = lit;
+      ring->push(unit);
+   }
+
+   ClauseManager::releaseClause(unit);
+
+   // Import the clauses of the other processes
+   vector<ClauseExchange *> remote;
+   vector<ClauseExchange *> clauses;
+
+   ring->read(cursor, remote);
+
+   int nRemote    = remote.size();
+   int duplicates = ClauseFilter::removeDuplicates(remote,
+                                                   this->filterGroup);
+
+   for (size_t k = 0; k < remote.size(); k++) {
+      if (remote[k]->size == 1 && UnitChannel::isEnabled()) {
+         remoteUnits.insert(remote[k]->lits[0]);
+         UnitChannel::addUnit(remote[k]->lits[0]);
+         ClauseManager::releaseClause(remote[k]);
+      } else {
+         clauses.push_back(remote[k]);
+      }
+   }
+
+   for (size_t j = 0; j < to.size(); j++) {
+      for (size_t k = 0; k < clauses.size(); k++) {
+         ClauseManager::increaseClause(clauses[k], 1);
+      }
+      stats.droppedClauses += to[j]->addLearnedClauses(clauses);
+   }
+
+   for (size_t k = 0; k < clauses.size(); k++) {
+      ClauseManager::releaseClause(clauses[k]);
+   }
+
+   stats.duplicateClauses += duplicates;
+
+   if (nRemote > 0) {
+      log(2, "Sharer %d imported %d clauses of other processes, %d " \
+          "duplicates\n", idSharer, nRemote, duplicates);
+   }
+}
+
+void
+ShmSharing::publish(const vector<ClauseExchange *> & selection)
+{
+   for (size_t k = 0; k < selection.size(); k++) {
+      ring->push(selection[k]);
+   }
+}
@@ -0,0 +1,59 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../clauses/ShmClauseRing.h"
+#include "../sharing/HordeSatSharing.h"
+
+#include <unordered_set>
+
+/// Hordesat like sharing strategy, the selected clauses are also exchanged
+/// with the other painless processes of the host through a shared memory
+/// ring. The ring is shared by the strategies of a process, one of them
+/// imports the clauses of the other processes.
+class ShmSharing : public HordeSatSharing
+{
+public:
+   /// Constructor.
+   ShmSharing(ShmClauseRing * ring, bool importer);
+
+   /// Share the clauses of the producers, then import the remote clauses.
+   void doSharing(int idSharer, const vector<SolverInterface *> & from,
+                  const vector<SolverInterface *> & to);
+
+protected:
+   /// Write the selection of a producer in the ring.
+   void publish(const vector<ClauseExchange *> & selection);
+
+   /// Ring of the host.
+   ShmClauseRing * ring;
+
+   /// Does this strategy import the remote clauses.
+   bool importer;
+
+   /// Position of the strategy in the ring.
+   ShmCursor cursor;
+
+   /// Position of the strategy in the unit channel.
+   int unitCursor;
+
+   /// Units imported from the ring, the other processes already have them.
+   unordered_set<int> remoteUnits;
+};
@@ -17,18 +17,28 @@
 // this program.  If not, see <http://www.gnu.org/licenses/>.
 // -----------------------------------------------------------------------------
 
+#include "../clauses/ClauseFilter.h"
 #include "../clauses/ClauseManager.h"
+#include "../sharing/MpiSharing.h"
 #include "../sharing/StrengtheningSharing.h"
 #include "../solvers/SolverFactory.h"
 #include "../utils/Logger.h"
 #include "../utils/Parameters.h"
+#include "../utils/System.h"
+
+#include <algorithm>
 
 StrengtheningSharing::StrengtheningSharing()
 {
    this->literalPerRound = Parameters::getIntParam("shr-lit", 1500);
+   this->roundDuration   = Parameters::getIntParam("shr-sleep", 500000) / 1e6;
+   this->lastRound       = getRelativeTime();
    this->initPhase = true;
-   // number of round corresponding to 5% of the 5000s timeout
-   this->roundBeforeIncrease = 250000000 / Parameters::getIntParam("shr-sleep", 500000);
+   // The init phase lasts 5% of the 5000s timeout, whatever the number of
+   // rounds triggered by the producers
+   this->initPhaseEnd = this->lastRound + 250;
+   this->filterGroup  = 0;
+   this->pool = new ThreadPool(Parameters::getIntParam("shr-helpers", 0));
 }
 
 StrengtheningSharing::~StrengtheningSharing()
@@ -36,88 +46,153 @@ StrengtheningSharing::~StrengtheningSharing()
     for (auto pair : this->databases) {
         delete pair.second;
     }
+
+    delete this->pool;
 }
 
 void
 StrengtheningSharing::doSharing(int idSharer, const vector<SolverInterface *> & from,
                            const vector<SolverInterface *> & to)
 {
-   static unsigned int round = 1;
-   // vector<ClauseExchange*> cls_to_reduce;
-   // vector<ClauseExchange*> cls_to_send;
+   // Rounds are triggered by the producers, so the literal budget follows
+   // the duration of the round
+   double now   = getRelativeTime();
+   double ratio = (now - this->lastRound) / this->roundDuration;
+   int budget   = literalPerRound * max(0.1, min(ratio, 2.0));
+
+   this->lastRound   = now;
+   this->filterGroup = ClauseFilter::getGroup(to);
+
+   // The map is only accessed here, the tasks get the database of their
+   // producer
+   vector<ClauseDatabase *> producerDatabases(from.size());
+
    for (size_t i = 0; i < from.size(); i++) {
-      int used, usedPercent, selectCount;
-      int id = from[i]->id;
+      if (!this->databases.count(from[i]->id)) {
+          this->databases[from[i]->id] = new ClauseDatabase(literalPerRound);
+      }
+
+      producerDatabases[i] = this->databases[from[i]->id];
+   }
+
+   // Producers are processed in parallel, each task only touches the
+   // database of its producer and its own result
+   rounds.clear();
+   rounds.resize(from.size());
+
+   pool->parallelFor(from.size(), [&](int i) {
+      shareProducer(idSharer, from[i], producerDatabases[i], to, budget,
+                    rounds[i]);
+   });
 
-      if (!this->databases.count(id)) {
-          this->databases[id] = new ClauseDatabase();
+   for (size_t i = 0; i < from.size(); i++) {
+      ProducerRound & result = rounds[i];
+      int id                 = from[i]->id;
+
+      stats.receivedClauses        += result.received;
+      stats.sharedClauses          += result.selection.size();
+      stats.droppedClauses         += result.dropped;
+      stats.duplicateClauses       += result.duplicates;
+      stats.producerClauses[id]    += result.selection.size() +
+                                      result.duplicates;
+      stats.producerDuplicates[id] += result.duplicates;
+
+      if (result.filled) {
+         this->initPhase = false;
       }
+   }
+
+   if (now >= this->initPhaseEnd) {
+      this->initPhase = false;
+   }
+}
+
+void
+StrengtheningSharing::shareProducer(int idSharer, SolverInterface * producer,
+                                    ClauseDatabase * database,
+                                    const vector<SolverInterface *> & to,
+                                    int budget, ProducerRound & result)
+{
+   int used, usedPercent, selectCount;
+   int id = producer->id;
 
-      tmp.clear();
-      // cls_to_reduce.clear();
-      // cls_to_send.clear();
+   vector<ClauseExchange *> & tmp = result.selection;
 
-      from[i]->getLearnedClauses(tmp);
+   producer->getLearnedClauses(tmp);
 
-      stats.receivedClauses += tmp.size();
+   result.received = tmp.size();
+
+   for (size_t k = 0; k < tmp.size(); k++) {
+      database->addClause(tmp[k]);
+   }
+
+   tmp.clear();
+
+   used        = database->giveSelection(tmp, budget, &selectCount);
+   usedPercent = (100 * used) / budget;
+
+   if (tmp.size() > 0) {
+      double sumLbd = 0;
 
       for (size_t k = 0; k < tmp.size(); k++) {
-         this->databases[id]->addClause(tmp[k]);
+         sumLbd += tmp[k]->lbd;
       }
 
-      tmp.clear();
+      log(2, "Sharer %d selected %d clauses of solver %d, average lbd " \
+          "%.2f, database capacity %d literals\n", idSharer, selectCount,
+          id, sumLbd / tmp.size(), database->getCapacity());
+   }
 
-      used        = this->databases[id]->giveSelection(tmp, literalPerRound, &selectCount);
-      usedPercent = (100 * used) / literalPerRound;
+   // The clauses of the CDCL solvers only go to the reducer, which exports
+   // them back, so only the clauses broadcast to the CDCL solvers are
+   // filtered and sent to the other processes, if any
+   if (producer->testStrengthening()) {
+      result.duplicates = ClauseFilter::removeDuplicates(tmp,
+                                                       this->filterGroup);
 
-      stats.sharedClauses += tmp.size();
+      MpiSharing::send(tmp);
+   }
 
-      if (usedPercent < 75 && !this->initPhase) {
-         from[i]->increaseClauseProduction();
-         log(2, "Sharer %d production increase for solver %d.\n", idSharer,
-             from[i]->id);
-      } else if (usedPercent > 98) {
-         from[i]->decreaseClauseProduction();
-         log(2, "Sharer %d production decrease for solver %d.\n", idSharer,
-             from[i]->id);
-      }
+   if (usedPercent < 75 && !this->initPhase) {
+      producer->increaseClauseProduction();
+      log(2, "Sharer %d production increase for solver %d.\n", idSharer,
+          producer->id);
+   } else if (usedPercent > 98) {
+      producer->decreaseClauseProduction();
+      log(2, "Sharer %d production decrease for solver %d.\n", idSharer,
+          producer->id);
+   }
 
-      if (selectCount > 0) {
-         log(2, "Sharer %d filled %d%% of its buffer %.2f\n", idSharer,
-             usedPercent, used/(float)selectCount);
-         this->initPhase = false;
-      }
-      if (round >= this->roundBeforeIncrease) {
-         this->initPhase = false;
-      }
+   if (selectCount > 0) {
+      log(2, "Sharer %d filled %d%% of its buffer %.2f\n", idSharer,
+          usedPercent, used/(float)selectCount);
+      result.filled = true;
+   }
 
-      /*for (ClauseExchange* c : tmp) {
-         if (c->lbd <= 10 && c->size >= 10) {
-            cls_to_reduce.push_back(c);
-         } else {
-            cls_to_send.push_back(c);
-         }
-      }*/
-      if (tmp.size() == 0)
-         continue;
-
-
-      for (size_t j = 0; j < to.size(); j++) {
-         bool strengthening_cdcl = (from[i]->testStrengthening() && !to[j]->testStrengthening()) ||
-                                    (!from[i]->testStrengthening() && to[j]->testStrengthening());
-         if (from[i]->id != to[j]->id && strengthening_cdcl) {
-            for (size_t k = 0; k < tmp.size(); k++) {
-               ClauseManager::increaseClause(tmp[k], 1);
-            }
-            to[j]->addLearnedClauses(tmp);
+   /*for (ClauseExchange* c : tmp) {
+      if (c->lbd <= 10 && c->size >= 10) {
+         cls_to_reduce.push_back(c);
+      } else {
+         cls_to_send.push_back(c);
+      }
+   }*/
+   if (tmp.size() == 0)
+      return;
+
+   for (size_t j = 0; j < to.size(); j++) {
+      bool strengthening_cdcl = (producer->testStrengthening() && !to[j]->testStrengthening()) ||
+                                 (!producer->testStrengthening() && to[j]->testStrengthening());
+      if (producer->id != to[j]->id && strengthening_cdcl) {
+         for (size_t k = 0; k < tmp.size(); k++) {
+            ClauseManager::increaseClause(tmp[k], 1);
          }
+         result.dropped += to[j]->addLearnedClauses(tmp);
       }
+   }
 
-      for (size_t k = 0; k < tmp.size(); k++) {
-         ClauseManager::releaseClause(tmp[k]);
-      }
+   for (size_t k = 0; k < tmp.size(); k++) {
+      ClauseManager::releaseClause(tmp[k]);
    }
-   round++;
 }
 
 SharingStatistics
@@ -22,6 +22,7 @@
 #include "../clauses/ClauseDatabase.h"
 #include "../sharing/SharingStrategy.h"
 #include "../solvers/SolverInterface.h"
+#include "../utils/ThreadPool.h"
 
 #include <unordered_map>
 #include <vector>
@@ -44,14 +45,28 @@ public:
    SharingStatistics getStatistics();
 
 protected:
+   /// Select the clauses of a producer and push them to the consumers, may
+   /// run in a helper thread.
+   void shareProducer(int idSharer, SolverInterface * producer,
+                      ClauseDatabase * database,
+                      const vector<SolverInterface *> & to, int budget,
+                      ProducerRound & result);
+
    /// Number of shared literals per round.
    int literalPerRound;
 
+   /// Expected duration of a round in seconds.
+   double roundDuration;
+
+   /// Time of the previous round.
+   double lastRound;
+
    /// Are we in init phase.
    bool initPhase;
 
-   /// Number of round before forcing an increase in production
-   int roundBeforeIncrease;
+   /// Time in seconds at which the init phase ends, production increases
+   /// are then forced.
+   double initPhaseEnd;
 
    /// Databse used to store the clauses.
    unordered_map<int, ClauseDatabase *> databases;
@@ -59,6 +74,12 @@ protected:
    /// Sharing statistics.
    SharingStatistics stats;
 
-   /// Used to manipulate clauses.
-   vector<ClauseExchange *> tmp;
+   /// Key of the consumers in the duplicate filter.
+   uint64_t filterGroup;
+
+   /// Work of the current round, one per producer.
+   vector<ProducerRound> rounds;
+
+   /// Helper threads processing the producers.
+   ThreadPool * pool;
 };
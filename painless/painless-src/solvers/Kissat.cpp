@@ -23,11 +23,16 @@
 #include "../kissat/src/witness.h"
 #include "../kissat/src/inline.h"
 #include "../kissat/src/literal.h"
+#include "../kissat/src/backtrack.h"
+#include "../kissat/src/decide.h"
+#include "../kissat/src/import.h"
+#include "../kissat/src/propsearch.h"
 
 #include "../utils/Logger.h"
 #include "../utils/System.h"
 #include "../utils/Parameters.h"
 #include "../clauses/ClauseManager.h"
+#include "../clauses/UnitChannel.h"
 
 void kissatExportClause(void *issuer, int lbd, std::vector<int> &cls)
 {
@@ -36,6 +41,13 @@ void kissatExportClause(void *issuer, int lbd, std::vector<int> &cls)
     if (lbd > kp->lbdLimit)
         return;
 
+    // Units go through the unit channel
+    if (cls.size() == 1 && UnitChannel::isEnabled())
+    {
+        UnitChannel::addUnit(cls[0]);
+        return;
+    }
+
     ClauseExchange *ncls = ClauseManager::allocClause(cls.size());
 
     ncls->lbd = lbd;
@@ -49,7 +61,7 @@ void kissatExportClause(void *issuer, int lbd, std::vector<int> &cls)
     ncls->from = kp->id;
     kp->exportClauses++;
 
-    kp->clausesToExport.addClause(ncls);
+    kp->exportClause(kp->clausesToExport, ncls);
 }
 
 int kissatImportUnit(void *issuer)
@@ -60,13 +72,17 @@ int kissatImportUnit(void *issuer)
 
     ClauseExchange *cls = NULL;
 
-    if (kp->unitsToImport.getClause(&cls) == false)
+    if (kp->unitsBatch.next(kp->unitsToImport, &cls) == false)
+    {
+        UnitChannel::nextUnit(kp->unitCursor, &l);
         return l;
+    }
 
     // while (kp->k_application.max_var < abs(cls->lits[0]))
     //     assert(0);
 
     l = cls->lits[0];
+    kp->recordImport(cls);
 
     ClauseManager::releaseClause(cls);
 
@@ -80,8 +96,16 @@ bool kissatImportClause(void *issuer, unsigned *lbd, std::vector<int> &kcls)
     ClauseExchange *cls = NULL;
     kcls.clear();
 
-    if (kp->clausesToImport.getClause(&cls) == false)
-        return false;
+    // Clauses of the logs are owned by the logs
+    bool fromLog = false;
+
+    if (kp->clausesBatch.next(kp->clausesToImport, &cls) == false)
+    {
+        if (kp->clausesLog.next(&cls) == false)
+            return false;
+
+        fromLog = true;
+    }
 
     for (int i = 0; i < cls->size; i++)
     {
@@ -91,8 +115,10 @@ bool kissatImportClause(void *issuer, unsigned *lbd, std::vector<int> &kcls)
     }
 
     *lbd = cls->lbd;
+    kp->recordImport(cls);
 
-    ClauseManager::releaseClause(cls);
+    if (!fromLog)
+        ClauseManager::releaseClause(cls);
     return true;
 }
 
@@ -100,6 +126,13 @@ Kissat::Kissat(int id) : SolverInterface(id, KISSAT), exportClauses(0)
 {
     lbdLimit = Parameters::getIntParam("lbd-limit", 2);
 
+    initImportLimits(clausesToImport, &unitsToImport);
+
+    strengthening = false;
+    searched = false;
+    stopSolver = false;
+    interruptTime = 0;
+
     solver = kissat_init();
 
     setSharingClauseFunctions(solver, this, &kissatExportClause, &kissatImportUnit, &kissatImportClause);
@@ -172,14 +205,18 @@ void Kissat::bumpVariableActivity(const int var, const int times)
 // Interrupt the SAT solving, so it can be started again with new assumptions
 void Kissat::setSolverInterrupt()
 {
-    stopSolver = true;
-    // kissat_interrupt(solver);
+    // The time of the first interrupt gives the stop latency
+    if (stopSolver.exchange(true) == false)
+        interruptTime = getRelativeTime();
+
+    // Checked by every TERMINATED site of the search and inprocessing
+    kissat_interrupt(solver);
 }
 
 void Kissat::unsetSolverInterrupt()
 {
     stopSolver = false;
-    // clearInterrupt(solver);
+    clearInterrupt(solver);
 }
 
 // Diversify the solver
@@ -204,37 +241,43 @@ void Kissat::diversify(int id)
 // return 10 for SAT, 20 for UNSAT, 0 for UNKNOWN
 SatResult Kissat::solve(const std::vector<int> &cube)
 {
-    unsetSolverInterrupt();
-    if (cube.size() > 0)
-        printf("kissat cube not emptu\n");
-    // std::vector<ClauseExchange *> tmp;
-
-    // tmp.clear();
-    // clausesToAdd.getClauses(tmp);
+    // The interrupt of the single search is kept, it may be requested
+    // before the search starts
+    if (strengthening)
+    {
+        unsetSolverInterrupt();
+        return solveAssumptions(cube);
+    }
 
-    // for (size_t ind = 0; ind < tmp.size(); ind++)
-    // {
-    //     vec<Lit> mcls;
+    // Kissat is not incremental, only one search is possible. Solving again
+    // after addClause is only supported by solveAssumptions, in
+    // strengthening mode
+    if (searched)
+    {
+        log(0, "Kissat %d cannot search twice\n", id);
+        return UNKNOWN;
+    }
 
-    //     for (int i = 0; i < tmp[ind]->size; i++)
-    //     {
-    //         int lit = tmp[ind]->lits[i];
-    //         int var = abs(lit);
+    // Kissat has no assumptions, adding the cube as units would make it part
+    // of the formula for good
+    if (cube.empty() == false)
+    {
+        log(0, "Kissat %d cannot search under a cube of %zu literals\n", id,
+            cube.size());
+        return UNKNOWN;
+    }
 
-    //         while (var > solver->nVars())
-    //             solver->newVar(true, false);
+    searched = true;
 
-    //         mcls.push(MINI_LIT(lit));
-    //     }
+    addPendingClauses(clausesToAdd);
 
-    //     ClauseManager::releaseClause(tmp[ind]);
+    finalAnalysis.clear();
 
-    //     if (solver->addClause(mcls) == false)
-    //     {
-    //         return UNSAT;
-    //     }
-    // }
     int res = kissat_solve(solver);
+
+    if (res == 0 && stopSolver)
+        log(1, "Kissat %d stopped %.2f ms after its interrupt\n", id,
+            (getRelativeTime() - interruptTime) * 1000);
     // printf("c [%d] Kissat: %d exported CONFLICT clauses\n", id, exportClauses);
 
 #ifndef NPROOFS
@@ -254,34 +297,53 @@ SatResult Kissat::solve(const std::vector<int> &cube)
 
 void Kissat::addClause(ClauseExchange *clause)
 {
+    // Kissat cannot search again, the search is not interrupted
     clausesToAdd.addClause(clause);
-    setSolverInterrupt();
 }
 
-void Kissat::addLearnedClause(ClauseExchange *clause)
+int Kissat::addLearnedClause(ClauseExchange *clause)
 {
     if (clause->size == 1)
-        unitsToImport.addClause(clause);
+        return unitsToImport.addClause(clause);
     else
-        clausesToImport.addClause(clause);
+        return clausesToImport.addClause(clause);
 }
 
 void Kissat::addClauses(const std::vector<ClauseExchange *> &clauses)
 {
+    // Kissat cannot search again, the search is not interrupted
     clausesToAdd.addClauses(clauses);
-
-    setSolverInterrupt();
 }
 
-void Kissat::addInitialClauses(const std::vector<ClauseExchange *> &clauses)
+void Kissat::addInitialClauses(const std::vector<int> &lits, int nVars)
 {
-    // kissat_reserve(solver, variables);
+    // The application only keeps the path of the formula
+    char *argv[2];
+    argv[1] = Parameters::getFilename();
+
+    init_app(&k_application, solver);
+    parse_options(&k_application, 2, argv);
+
+#ifndef NPROOFS
+    write_proof(&k_application);
+#endif
+
+    // Same calls as the parser of Kissat
+    k_application.max_var = nVars;
+    kissat_reserve(solver, nVars);
+
+    for (size_t i = 0; i < lits.size(); i++)
+        kissat_add(solver, lits[i]);
 }
 
-void Kissat::addLearnedClauses(const std::vector<ClauseExchange *> &clauses)
+int Kissat::addLearnedClauses(const std::vector<ClauseExchange *> &clauses)
 {
+    int dropped = 0;
+
     for (size_t i = 0; i < clauses.size(); i++)
-        addLearnedClause(clauses[i]);
+        dropped += addLearnedClause(clauses[i]);
+
+    return dropped;
 }
 
 void Kissat::getLearnedClauses(std::vector<ClauseExchange *> &clauses)
@@ -331,28 +393,153 @@ std::vector<int> Kissat::getModel()
 
 vector<int> Kissat::getFinalAnalysis()
 {
-    vector<int> outCls;
-
-    //    for (int i = 0; i < solver->conflict.size(); i++) {
-    //       outCls.push_back(INT_LIT(solver->conflict[i]));
-    //    }
-
-    return outCls;
+    return finalAnalysis;
 }
 
 vector<int> Kissat::getSatAssumptions()
 {
-    vector<int> outCls;
-    // vec<Lit> lits;
-    // solver->getAssumptions(lits);
-    // for (int i = 0; i < lits.size(); i++)
-    // {
-    //     outCls.push_back(-(INT_LIT(lits[i])));
-    // }
-    return outCls;
+    return satAssumptions;
 };
 
 void Kissat::setStrengthening(bool b)
 {
-    // solver->setStrengthening(b);
+    strengthening = b;
+}
+
+// Add the permanent clauses waiting in a buffer, must be called at level 0
+void Kissat::addPendingClauses(ClauseBuffer &buffer)
+{
+    std::vector<ClauseExchange *> tmp;
+
+    buffer.getClauses(tmp);
+
+    for (size_t i = 0; i < tmp.size(); i++)
+    {
+        for (unsigned j = 0; j < tmp[i]->size; j++)
+            kissat_add(solver, tmp[i]->lits[j]);
+
+        kissat_add(solver, 0);
+
+        ClauseManager::releaseClause(tmp[i]);
+    }
+}
+
+// Propagate the assumptions one by one without searching, as the strengthening
+// mode of MapleCOMSPS
+SatResult Kissat::solveAssumptions(const std::vector<int> &cube)
+{
+    finalAnalysis.clear();
+    satAssumptions.clear();
+
+    kissat_backtrack(solver, 0);
+
+    // The shared units and clauses are added at level 0
+    addPendingClauses(clausesToAdd);
+    addPendingClauses(unitsToImport);
+
+    int unit;
+
+    while (UnitChannel::isEnabled() && UnitChannel::nextUnit(unitCursor, &unit))
+    {
+        kissat_add(solver, unit);
+        kissat_add(solver, 0);
+    }
+
+    if (solver->inconsistent)
+        return UNSAT;
+
+    std::vector<std::pair<unsigned, int>> decisions;
+
+    for (size_t i = 0; i < cube.size(); i++)
+    {
+        const unsigned lit = kissat_import_literal(solver, cube[i]);
+        const value value = VALUE(lit);
+
+        // Implied by the previous assumptions
+        if (value > 0)
+            continue;
+
+        if (value < 0)
+        {
+            const unsigned falsified = NOT(lit);
+
+            finalAnalysis.push_back(-cube[i]);
+            analyzeFinal(&falsified, 1, decisions);
+            return UNSAT;
+        }
+
+        kissat_internal_assume(solver, lit);
+        decisions.push_back(std::make_pair(lit, cube[i]));
+        satAssumptions.push_back(-cube[i]);
+
+        clause *conflict = kissat_search_propagate(solver);
+
+        if (conflict)
+        {
+            analyzeFinal(conflict->lits, conflict->size, decisions);
+            return UNSAT;
+        }
+    }
+
+    return SAT;
+}
+
+// Add to the final analysis the negation of the assumptions implying the
+// given literals, the trail is walked backward marking the reasons
+void Kissat::analyzeFinal(const unsigned *lits, unsigned size,
+                          const std::vector<std::pair<unsigned, int>> &decisions)
+{
+    std::vector<bool> seen(VARS, false);
+
+    for (unsigned i = 0; i < size; i++)
+    {
+        if (LEVEL(lits[i]) > 0)
+            seen[IDX(lits[i])] = true;
+    }
+
+    const unsigned *trail = BEGIN_STACK(solver->trail);
+
+    for (size_t i = SIZE_STACK(solver->trail); i-- > 0;)
+    {
+        const unsigned lit = trail[i];
+
+        if (!seen[IDX(lit)])
+            continue;
+
+        assigned *a = ASSIGNED(lit);
+
+        if (a->reason == DECISION)
+        {
+            for (size_t j = 0; j < decisions.size(); j++)
+            {
+                if (decisions[j].first == lit)
+                    finalAnalysis.push_back(-decisions[j].second);
+            }
+        }
+        else if (a->binary)
+        {
+            if (LEVEL(a->reason) > 0)
+                seen[IDX(a->reason)] = true;
+        }
+        else
+        {
+            clause *reason = kissat_unchecked_dereference_clause(solver, a->reason);
+
+            for (all_literals_in_clause(other, reason))
+            {
+                if (other != lit && LEVEL(other) > 0)
+                    seen[IDX(other)] = true;
+            }
+        }
+    }
+}
+
+bool Kissat::subscribeClauseLog(ClauseLog *log)
+{
+    return clausesLog.addLog(log, id);
+}
+
+void Kissat::unsubscribeClauseLogs()
+{
+    clausesLog.close();
 }
@@ -63,13 +63,13 @@ public:
    void addClauses(const vector<ClauseExchange *> &clauses);
 
    /// Add a list of initial clauses to the formula.
-   void addInitialClauses(const vector<ClauseExchange *> &clauses);
+   void addInitialClauses(const vector<int> &lits, int nVars);
 
    /// Add a learned clause to the formula.
-   void addLearnedClause(ClauseExchange *clause);
+   int addLearnedClause(ClauseExchange *clause);
 
    /// Add a list of learned clauses to the formula.
-   void addLearnedClauses(const vector<ClauseExchange *> &clauses);
+   int addLearnedClauses(const vector<ClauseExchange *> &clauses);
 
    /// Get a list of learned clauses.
    void getLearnedClauses(vector<ClauseExchange *> &clauses);
@@ -92,6 +92,7 @@ public:
    /// Constructor.
    Kissat(int id);
 
+
    /// Destructor.
    virtual ~Kissat();
 
@@ -99,9 +100,27 @@ public:
 
    vector<int> getSatAssumptions();
 
+   /// Subscribe to a broadcast clause log.
+   bool subscribeClauseLog(ClauseLog * log);
+
+   /// Unsubscribe from the clause logs.
+   void unsubscribeClauseLogs();
+
+   /// In strengthening mode, the assumptions are only propagated.
    void setStrengthening(bool b);
 
 protected:
+   /// Add the permanent clauses waiting in a buffer.
+   void addPendingClauses(ClauseBuffer &buffer);
+
+   /// Propagate the assumptions without searching, return UNSAT if an
+   /// assumption is falsified, SAT otherwise.
+   SatResult solveAssumptions(const vector<int> &cube);
+
+   /// Compute the assumptions implying some literals in the final analysis.
+   void analyzeFinal(const unsigned *lits, unsigned size,
+                     const vector<pair<unsigned, int>> &decisions);
+
    /// Pointer to a Maple solver.
    kissat *solver;
    application k_application;
@@ -110,6 +129,13 @@ protected:
    ClauseBuffer clausesToImport;
    ClauseBuffer unitsToImport;
 
+   /// Batches of imported clauses consumed by the solver thread.
+   ClauseBatch clausesBatch;
+   ClauseBatch unitsBatch;
+
+   /// Cursors on the broadcast logs this solver is subscribed to.
+   ClauseLogReader clausesLog;
+
    /// Buffer used to export clauses (units included).
    ClauseBuffer clausesToExport;
 
@@ -119,10 +145,25 @@ protected:
    /// Size limit used to share clauses.
    int lbdLimit;
 
+   /// Negation of the failed assumptions of the last UNSAT call.
+   vector<int> finalAnalysis;
+
+   /// Negation of the decided assumptions of the last SAT call.
+   vector<int> satAssumptions;
+
+   /// Are the assumptions only propagated.
+   bool strengthening;
+
+   /// Has the single search of Kissat been done.
+   bool searched;
+
    int exportClauses;
    /// Used to stop or continue the resolution.
    atomic<bool> stopSolver;
 
+   /// Time of the first interrupt of the search, in seconds.
+   atomic<double> interruptTime;
+
    /// Callback to export/import clauses.
    friend void kissatExportClause(void *, int, vector<int> &);
    friend int kissatImportUnit(void *);
@@ -26,6 +26,7 @@
 #include "../utils/System.h"
 #include "../utils/Parameters.h"
 #include "../clauses/ClauseManager.h"
+#include "../clauses/UnitChannel.h"
 #include "../solvers/MapleCOMSPSSolver.h"
 
 using namespace MapleCOMSPS;
@@ -51,6 +52,12 @@ void cbkMapleCOMSPSExportClause(void * issuer, int lbd, vec<Lit> & cls)
 	if (lbd > mp->lbdLimit)
 		return;
 
+	// Units go through the unit channel
+	if (cls.size() == 1 && UnitChannel::isEnabled()) {
+		UnitChannel::addUnit(INT_LIT(cls[0]));
+		return;
+	}
+
 	ClauseExchange * ncls = ClauseManager::allocClause(cls.size());
 
 	for (int i = 0; i < cls.size(); i++) {
@@ -60,7 +67,7 @@ void cbkMapleCOMSPSExportClause(void * issuer, int lbd, vec<Lit> & cls)
    ncls->lbd  = lbd;
    ncls->from = mp->id;
 
-   mp->clausesToExport.addClause(ncls);
+   mp->exportClause(mp->clausesToExport, ncls);
 }
 
 Lit cbkMapleCOMSPSImportUnit(void * issuer)
@@ -71,10 +78,17 @@ Lit cbkMapleCOMSPSImportUnit(void * issuer)
 
    ClauseExchange * cls = NULL;
 
-   if (mp->unitsToImport.getClause(&cls) == false)
+   if (mp->unitsBatch.next(mp->unitsToImport, &cls) == false) {
+      int lit;
+
+      if (UnitChannel::nextUnit(mp->unitCursor, &lit))
+         l = MINI_LIT(lit);
+
       return l;
+   }
 
    l = MINI_LIT(cls->lits[0]);
+   mp->recordImport(cls);
 
    ClauseManager::releaseClause(cls);
 
@@ -87,15 +101,26 @@ bool cbkMapleCOMSPSImportClause(void * issuer, int * lbd, vec<Lit> & mcls)
 
    ClauseExchange * cls = NULL;
 
-   if (mp->clausesToImport.getClause(&cls) == false)
+   if (mp->clausesBatch.next(mp->clausesToImport, &cls)) {
+      makeMiniVec(cls, mcls);
+      mp->recordImport(cls);
+
+      *lbd = cls->lbd;
+
+      ClauseManager::releaseClause(cls);
+
+      return true;
+   }
+
+   // Clauses of the logs are owned by the logs
+   if (mp->clausesLog.next(&cls) == false)
       return false;
 
    makeMiniVec(cls, mcls);
+   mp->recordImport(cls);
 
    *lbd = cls->lbd;
 
-   ClauseManager::releaseClause(cls);
-
    return true;
 }
 
@@ -103,6 +128,8 @@ MapleCOMSPSSolver::MapleCOMSPSSolver(int id) : SolverInterface(id, MAPLE)
 {
 	lbdLimit = Parameters::getIntParam("lbd-limit", 2);
 
+	initImportLimits(clausesToImport, &unitsToImport);
+
 	solver = new SimpSolver();
 
 	solver->cbkExportClause = cbkMapleCOMSPSExportClause;
@@ -116,6 +143,8 @@ MapleCOMSPSSolver::MapleCOMSPSSolver(const MapleCOMSPSSolver & other, int id) :
 {
 	lbdLimit = Parameters::getIntParam("lbd-limit", 2);
 
+	initImportLimits(clausesToImport, &unitsToImport);
+
 	solver = new SimpSolver(*(other.solver));
 
 	solver->cbkExportClause = cbkMapleCOMSPSExportClause;
@@ -152,7 +181,31 @@ MapleCOMSPSSolver::getVariablesCount()
 int
 MapleCOMSPSSolver::getDivisionVariable()
 {
-   return (rand() % getVariablesCount()) + 1;
+   vec<Lit> assumptions;
+   vector<bool> assumed(solver->nVars(), false);
+
+   solver->getAssumptions(assumptions);
+
+   for (int i = 0; i < assumptions.size(); i++) {
+      assumed[var(assumptions[i])] = true;
+   }
+
+   // The most active variable not assigned at level 0, not eliminated and
+   // not in the last cube, 0 if there is none
+   Var    best         = var_Undef;
+   double bestActivity = -1;
+
+   for (Var v = 0; v < solver->nVars(); v++) {
+      if (assumed[v] || solver->value(v) != l_Undef || solver->isEliminated(v))
+         continue;
+
+      if (solver->varActivity(v) > bestActivity) {
+         best         = v;
+         bestActivity = solver->varActivity(v);
+      }
+   }
+
+   return best == var_Undef ? 0 : best + 1;
 }
 
 // Set initial phase for a given variable
@@ -213,13 +266,18 @@ MapleCOMSPSSolver::diversify(int id)
 SatResult
 MapleCOMSPSSolver::solve(const vector<int> & cube)
 {
-   unsetSolverInterrupt();
-
    vector<ClauseExchange *> tmp;
 
    tmp.clear();
    clausesToAdd.getClauses(tmp);
 
+   // Clauses are added at level 0, the interrupt of their addition is
+   // removed, any other interrupt stops the search before it starts
+   if (tmp.size() > 0) {
+      unsetSolverInterrupt();
+      solver->resetTrail();
+   }
+
    for (size_t ind = 0; ind < tmp.size(); ind++) {
       vec<Lit> mcls;
       makeMiniVec(tmp[ind], mcls);
@@ -256,13 +314,13 @@ MapleCOMSPSSolver::addClause(ClauseExchange * clause)
    setSolverInterrupt();
 }
 
-void
+int
 MapleCOMSPSSolver::addLearnedClause(ClauseExchange * clause)
 {
    if (clause->size == 1) {
-      unitsToImport.addClause(clause);
+      return unitsToImport.addClause(clause);
    } else {
-      clausesToImport.addClause(clause);
+      return clausesToImport.addClause(clause);
    }
 }
 
@@ -275,34 +333,40 @@ MapleCOMSPSSolver::addClauses(const vector<ClauseExchange *> & clauses)
 }
 
 void
-MapleCOMSPSSolver::addInitialClauses(const vector<ClauseExchange *> & clauses)
+MapleCOMSPSSolver::addInitialClauses(const vector<int> & lits, int nVars)
 {
-   for (size_t ind = 0; ind < clauses.size(); ind++) {
-      vec<Lit> mcls;
-
-      for (size_t i = 0; i < clauses[ind]->size; i++) {
-         int lit = clauses[ind]->lits[i];
-         int var = abs(lit);
+   while (solver->nVars() < nVars) {
+      solver->newVar();
+   }
 
-         while (solver->nVars() < var) {
-            solver->newVar();
-         }
+   vec<Lit> mcls;
+   bool unsat = false;
 
-         mcls.push(MINI_LIT(lit));
+   for (size_t i = 0; i < lits.size(); i++) {
+      if (lits[i] != 0) {
+         mcls.push(MINI_LIT(lits[i]));
+         continue;
       }
 
-      if (solver->addClause(mcls) == false) {
+      if (solver->addClause_(mcls) == false && unsat == false) {
          printf("c unsat when adding initial cls\n");
+         unsat = true;
       }
+
+      mcls.clear();
    }
 }
 
-void
+int
 MapleCOMSPSSolver::addLearnedClauses(const vector<ClauseExchange *> & clauses)
 {
+   int dropped = 0;
+
    for (size_t i = 0; i < clauses.size(); i++) {
-      addLearnedClause(clauses[i]);
+      dropped += addLearnedClause(clauses[i]);
    }
+
+   return dropped;
 }
 
 void
@@ -382,4 +446,76 @@ MapleCOMSPSSolver::getSatAssumptions() {
 void
 MapleCOMSPSSolver::setStrengthening(bool b) {
    solver->setStrengthening(b);
+
+   // Consecutive strengthenings reuse the trail of their common assumptions
+   solver->setKeepTrail(b && !Parameters::getBoolParam("no-reducer-trail"));
+}
+
+bool
+MapleCOMSPSSolver::setCubing(bool b)
+{
+   // The variables of the cubes must not be eliminated
+   solver->use_elim = !b;
+
+   return true;
+}
+
+void
+MapleCOMSPSSolver::localizeMemory()
+{
+   // The garbage collection copies the clauses in a new arena
+   solver->garbageCollect();
+}
+
+bool
+MapleCOMSPSSolver::lookahead(const vector<int> & cube, const vector<int> & lits,
+                             int & assigned, vector<int> & counts)
+{
+   vec<Lit> miniCube;
+
+   for (size_t i = 0; i < cube.size(); i++) {
+      miniCube.push(MINI_LIT(cube[i]));
+   }
+
+   assigned = solver->lookaheadCube(miniCube);
+
+   counts.assign(lits.size(), -1);
+
+   if (assigned >= 0) {
+      for (size_t i = 0; i < lits.size(); i++) {
+         counts[i] = solver->lookaheadLit(MINI_LIT(lits[i]));
+      }
+   }
+
+   solver->lookaheadEnd();
+
+   return true;
+}
+
+vector<int>
+MapleCOMSPSSolver::getOccurrences()
+{
+   vec<int> occ;
+
+   solver->getOccurrences(occ);
+
+   vector<int> result(occ.size() + 1, 0);
+
+   for (int v = 0; v < occ.size(); v++) {
+      result[v + 1] = occ[v];
+   }
+
+   return result;
+}
+
+bool
+MapleCOMSPSSolver::subscribeClauseLog(ClauseLog * log)
+{
+   return clausesLog.addLog(log, id);
+}
+
+void
+MapleCOMSPSSolver::unsubscribeClauseLogs()
+{
+   clausesLog.close();
 }
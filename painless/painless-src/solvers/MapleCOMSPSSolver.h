@@ -68,13 +68,13 @@ public:
    void addClauses(const vector<ClauseExchange *> & clauses);
    
    /// Add a list of initial clauses to the formula.
-   void addInitialClauses(const vector<ClauseExchange *> & clauses);
+   void addInitialClauses(const vector<int> & lits, int nVars);
 
    /// Add a learned clause to the formula.
-   void addLearnedClause(ClauseExchange * clause);
+   int addLearnedClause(ClauseExchange * clause);
    
    /// Add a list of learned clauses to the formula.
-   void addLearnedClauses(const vector<ClauseExchange *> & clauses);
+   int addLearnedClauses(const vector<ClauseExchange *> & clauses);
 
    /// Get a list of learned clauses.
    void getLearnedClauses(vector<ClauseExchange *> & clauses);
@@ -107,8 +107,27 @@ public:
 
    vector<int> getSatAssumptions();
 
+   /// Subscribe to a broadcast clause log.
+   bool subscribeClauseLog(ClauseLog * log);
+
+   /// Unsubscribe from the clause logs.
+   void unsubscribeClauseLogs();
+
    void setStrengthening(bool b);
 
+   /// Prepare the solver to solve cubes, no variable is eliminated.
+   bool setCubing(bool b);
+
+   /// Reallocate the clause arena from the calling thread.
+   void localizeMemory();
+
+   /// Propagate a cube, then each literal of a list on top of it.
+   bool lookahead(const vector<int> & cube, const vector<int> & lits,
+                  int & assigned, vector<int> & counts);
+
+   /// Return the number of occurrences of each variable.
+   vector<int> getOccurrences();
+
 
 protected:
    /// Pointer to a MapleCOMSPS solver.
@@ -118,6 +137,13 @@ protected:
    ClauseBuffer clausesToImport;
    ClauseBuffer unitsToImport;
 
+   /// Batches of imported clauses consumed by the solver thread.
+   ClauseBatch clausesBatch;
+   ClauseBatch unitsBatch;
+
+   /// Cursors on the broadcast logs this solver is subscribed to.
+   ClauseLogReader clausesLog;
+
    /// Buffer used to export clauses (units included).
    ClauseBuffer clausesToExport;
 
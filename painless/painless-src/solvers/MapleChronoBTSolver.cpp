@@ -26,6 +26,7 @@
 #include "../utils/System.h"
 #include "../utils/Parameters.h"
 #include "../clauses/ClauseManager.h"
+#include "../clauses/UnitChannel.h"
 #include "../solvers/MapleChronoBTSolver.h"
 #include <algorithm>
 
@@ -52,6 +53,12 @@ void cbkMapleChronoBTExportClause(void * issuer, int lbd, vec<Lit> & cls)
 	if (lbd > mp->lbdLimit)
 		return;
 
+	// Units go through the unit channel
+	if (cls.size() == 1 && UnitChannel::isEnabled()) {
+		UnitChannel::addUnit(INT_LIT(cls[0]));
+		return;
+	}
+
 	ClauseExchange * ncls = ClauseManager::allocClause(cls.size());
 
 	for (int i = 0; i < cls.size(); i++) {
@@ -61,7 +68,7 @@ void cbkMapleChronoBTExportClause(void * issuer, int lbd, vec<Lit> & cls)
    ncls->lbd  = lbd;
    ncls->from = mp->id;
 
-   mp->clausesToExport.addClause(ncls);
+   mp->exportClause(mp->clausesToExport, ncls);
 }
 
 Lit cbkMapleChronoBTImportUnit(void * issuer)
@@ -72,10 +79,17 @@ Lit cbkMapleChronoBTImportUnit(void * issuer)
 
    ClauseExchange * cls = NULL;
 
-   if (mp->unitsToImport.getClause(&cls) == false)
+   if (mp->unitsBatch.next(mp->unitsToImport, &cls) == false) {
+      int lit;
+
+      if (UnitChannel::nextUnit(mp->unitCursor, &lit))
+         l = MINI_LIT(lit);
+
       return l;
+   }
 
    l = MINI_LIT(cls->lits[0]);
+   mp->recordImport(cls);
 
    ClauseManager::releaseClause(cls);
 
@@ -88,15 +102,26 @@ bool cbkMapleChronoBTImportClause(void * issuer, int * lbd, vec<Lit> & mcls)
 
    ClauseExchange * cls = NULL;
 
-   if (mp->clausesToImport.getClause(&cls) == false)
+   if (mp->clausesBatch.next(mp->clausesToImport, &cls)) {
+      makeMiniVec(cls, mcls);
+      mp->recordImport(cls);
+
+      *lbd = cls->lbd;
+
+      ClauseManager::releaseClause(cls);
+
+      return true;
+   }
+
+   // Clauses of the logs are owned by the logs
+   if (mp->clausesLog.next(&cls) == false)
       return false;
 
    makeMiniVec(cls, mcls);
+   mp->recordImport(cls);
 
    *lbd = cls->lbd;
 
-   ClauseManager::releaseClause(cls);
-
    return true;
 }
 
@@ -104,6 +129,8 @@ MapleChronoBTSolver::MapleChronoBTSolver(int id) : SolverInterface(id, MINISAT)
 {
 	lbdLimit = Parameters::getIntParam("lbd-limit", 2);
 
+	initImportLimits(clausesToImport, &unitsToImport);
+
 	solver = new SimpSolver();
 
 	solver->cbkExportClause = cbkMapleChronoBTExportClause;
@@ -241,13 +268,13 @@ MapleChronoBTSolver::addClause(ClauseExchange * clause)
    setSolverInterrupt();
 }
 
-void
+int
 MapleChronoBTSolver::addLearnedClause(ClauseExchange * clause)
 {
    if (clause->size == 1) {
-      unitsToImport.addClause(clause);
+      return unitsToImport.addClause(clause);
    } else {
-      clausesToImport.addClause(clause);
+      return clausesToImport.addClause(clause);
    }
 }
 
@@ -260,34 +287,40 @@ MapleChronoBTSolver::addClauses(const vector<ClauseExchange *> & clauses)
 }
 
 void
-MapleChronoBTSolver::addInitialClauses(const vector<ClauseExchange *> & clauses)
+MapleChronoBTSolver::addInitialClauses(const vector<int> & lits, int nVars)
 {
-   for (size_t ind = 0; ind < clauses.size(); ind++) {
-      vec<Lit> mcls;
-
-      for (size_t i = 0; i < clauses[ind]->size; i++) {
-         int lit = clauses[ind]->lits[i];
-         int var = abs(lit);
+   while (solver->nVars() < nVars) {
+      solver->newVar();
+   }
 
-         while (solver->nVars() < var) {
-            solver->newVar();
-         }
+   vec<Lit> mcls;
+   bool unsat = false;
 
-         mcls.push(MINI_LIT(lit));
+   for (size_t i = 0; i < lits.size(); i++) {
+      if (lits[i] != 0) {
+         mcls.push(MINI_LIT(lits[i]));
+         continue;
       }
 
-      if (solver->addClause(mcls) == false) {
+      if (solver->addClause_(mcls) == false && unsat == false) {
          printf("c unsat when adding initial cls\n");
+         unsat = true;
       }
+
+      mcls.clear();
    }
 }
 
-void
+int
 MapleChronoBTSolver::addLearnedClauses(const vector<ClauseExchange *> & clauses)
 {
+   int dropped = 0;
+
    for (size_t i = 0; i < clauses.size(); i++) {
-      addLearnedClause(clauses[i]);
+      dropped += addLearnedClause(clauses[i]);
    }
+
+   return dropped;
 }
 
 void
@@ -358,3 +391,15 @@ MapleChronoBTSolver::getSatAssumptions()
    vector<int> outCls;
    return outCls;
 }
+
+bool
+MapleChronoBTSolver::subscribeClauseLog(ClauseLog * log)
+{
+   return clausesLog.addLog(log, id);
+}
+
+void
+MapleChronoBTSolver::unsubscribeClauseLogs()
+{
+   clausesLog.close();
+}
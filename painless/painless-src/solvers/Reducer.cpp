@@ -28,6 +28,8 @@
 #include "../clauses/ClauseManager.h"
 #include "../solvers/Reducer.h"
 
+#include <algorithm>
+
 using namespace MapleCOMSPS;
 
 // Macros for minisat literal representation conversion
@@ -43,16 +45,60 @@ static void makeMiniVec(ClauseExchange * cls, vec<Lit> & mcls)
    }
 }
 
-Reducer::Reducer(int id, SolverInterface *_solver) :
-   SolverInterface(id, MAPLE)
+// Assumptions used to strengthen a clause, the negated literals are sorted so
+// clauses with common literals share prefixes of assumptions
+static void makeAssumptions(ClauseExchange * cls, vector<int> & assumps)
 {
-   solver = _solver;
-   solver->setStrengthening(true);
+   for (size_t i = 0; i < cls->size; i++) {
+      assumps.push_back(-cls->lits[i]);
+   }
+
+   sort(assumps.begin(), assumps.end());
+}
+
+// Main executed by the helper threads of a reducer
+static void * mainReducerWorker(void * arg)
+{
+   ReducerWorker * worker = (ReducerWorker *)arg;
+
+   worker->reducer->work(worker);
+
+   return NULL;
+}
+
+Reducer::Reducer(int id, const vector<SolverInterface *> & solvers) :
+   SolverInterface(id, MAPLE),
+   filter(Parameters::getIntParam("reducer-filter-size", 25),
+          Parameters::getIntParam("reducer-filter-hashes", 4))
+{
+   workers.resize(solvers.size());
+
+   for (size_t i = 0; i < solvers.size(); i++) {
+      workers[i].reducer       = this;
+      workers[i].solver        = solvers[i];
+      workers[i].thread        = NULL;
+      workers[i].idleTime      = 0;
+      workers[i].busyTime      = 0;
+      workers[i].nReduced      = 0;
+      workers[i].nStrengthened = 0;
+
+      workers[i].solver->setStrengthening(true);
+   }
+
+   initImportLimits(clausesToImport, NULL);
+
+   alwaysShare = Parameters::getIntParam("shr-strat", 1) == 3;
+   waitTime    = Parameters::getIntParam("reducer-wait", 100000);
+   chunkSize   = Parameters::getIntParam("reducer-chunk", 64);
+   interrupted = false;
+   unsat       = false;
 }
 
 Reducer::~Reducer()
 {
-   delete solver;
+   for (size_t i = 0; i < workers.size(); i++) {
+      delete workers[i].solver;
+   }
 }
 
 bool
@@ -65,48 +111,64 @@ Reducer::loadFormula(const char* filename)
 int
 Reducer::getVariablesCount()
 {
-   return solver->getVariablesCount();
+   return workers[0].solver->getVariablesCount();
 }
 
 // Get a variable suitable for search splitting
 int
 Reducer::getDivisionVariable()
 {
-   return solver->getDivisionVariable();
+   return workers[0].solver->getDivisionVariable();
 }
 
 // Set initial phase for a given variable
 void
 Reducer::setPhase(const int var, const bool phase)
 {
-   solver->setPhase(var, phase);
+   for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].solver->setPhase(var, phase);
+   }
 }
 
 // Bump activity for a given variable
 void
 Reducer::bumpVariableActivity(const int var, const int times)
 {
-   solver->bumpVariableActivity(var, times);
+   for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].solver->bumpVariableActivity(var, times);
+   }
 }
 
 // Interrupt the SAT solving, so it can be started again with new assumptions
 void
 Reducer::setSolverInterrupt()
 {
-   solver->setSolverInterrupt();
+   interrupted = true;
+
+   for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].solver->setSolverInterrupt();
+   }
+
+   importCondition.signal();
 }
 
 void
 Reducer::unsetSolverInterrupt()
 {
-   solver->unsetSolverInterrupt();
+   interrupted = false;
+
+   for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].solver->unsetSolverInterrupt();
+   }
 }
 
 // Diversify the solver
 void
 Reducer::diversify(int id)
 {
-   solver->diversify(id);
+   for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].solver->diversify(id);
+   }
 }
 
 // Solve the formula with a given set of assumptions
@@ -114,45 +176,126 @@ Reducer::diversify(int id)
 SatResult
 Reducer::solve(const vector<int> & cube)
 {
-   unsetSolverInterrupt();
+   // The calling thread is the first worker
+   for (size_t i = 1; i < workers.size(); i++) {
+      workers[i].thread = new Thread(mainReducerWorker, &workers[i]);
+   }
+
+   work(&workers[0]);
 
-   while (true) {
-      ClauseExchange *cls;
-      ClauseExchange *strengthenedCls;
-      if (clausesToImport.getClause(&cls) == false) {
+   for (size_t i = 1; i < workers.size(); i++) {
+      workers[i].thread->join();
+      delete workers[i].thread;
+      workers[i].thread = NULL;
+   }
+
+   printStatsStrengthening();
+
+   return unsat ? UNSAT : UNKNOWN;
+}
+
+void
+Reducer::work(ReducerWorker * worker)
+{
+   vector<ClauseExchange *> chunk;
+   vector<pair<vector<int>, ClauseExchange *> > prefixes;
+   ClauseExchange * cls;
+
+   while (interrupted == false) {
+      chunk.clear();
+
+      while (chunk.size() < chunkSize && clausesToImport.getClause(&cls)) {
+         chunk.push_back(cls);
+      }
+
+      if (chunk.empty()) {
+         // Wait for the sharer instead of spinning on an empty buffer
+         double start = getRelativeTime();
+         importCondition.waitFor(waitTime);
+         worker->idleTime += getRelativeTime() - start;
          continue;
       }
-      if (strengthened(cls, &strengthenedCls))
-      {
-         if (strengthenedCls->size == 0) {
-            return UNSAT;
+
+      // Wake up another worker for the remaining clauses
+      if (clausesToImport.size() > 0) {
+         importCondition.signal();
+      }
+
+      // Consecutive clauses with a common prefix of assumptions reuse the
+      // trail of the solver for this prefix
+      prefixes.resize(chunk.size());
+
+      for (size_t i = 0; i < chunk.size(); i++) {
+         prefixes[i].first.clear();
+         makeAssumptions(chunk[i], prefixes[i].first);
+         prefixes[i].second = chunk[i];
+      }
+
+      sort(prefixes.begin(), prefixes.end());
+
+      for (size_t i = 0; i < chunk.size(); i++) {
+         chunk[i] = prefixes[i].second;
+      }
+
+      double start = getRelativeTime();
+
+      for (size_t i = 0; i < chunk.size(); i++) {
+         ClauseExchange * strengthenedCls;
+
+         if (interrupted == false &&
+             strengthened(worker->solver, chunk[i], &strengthenedCls))
+         {
+            worker->nStrengthened++;
+
+            if (strengthenedCls->size == 0) {
+               ClauseManager::releaseClause(strengthenedCls);
+               unsat       = true;
+               interrupted = true;
+            } else {
+               exportLock.lock();
+               exportClause(clausesToExport, strengthenedCls);
+               exportLock.unlock();
+            }
          }
-         ClauseManager::increaseClause(strengthenedCls);
-         clausesToExport.addClause(strengthenedCls);
+
+         worker->nReduced++;
+
+         ClauseManager::releaseClause(chunk[i]);
       }
+
+      worker->busyTime += getRelativeTime() - start;
    }
-   return UNKNOWN;
+
+   // Pass the interruption on to the waiting workers
+   importCondition.signal();
 }
 
 
 bool
-Reducer::strengthened(ClauseExchange * cls,
-                               ClauseExchange ** outCls)
+Reducer::strengthened(SolverInterface * solver, ClauseExchange * cls,
+                      ClauseExchange ** outCls)
 {
    vector<int> assumps;
    vector<int> tmpNewClause;
-   bool always_share = Parameters::getIntParam("shr-strat", 1) == 3;
-   for (size_t ind = 0; ind < cls->size; ind++) {
-      assumps.push_back(-cls->lits[ind]);
-   }
+   *outCls = NULL;
+   makeAssumptions(cls, assumps);
    SatResult res = solver->solve(assumps);
+
+   // An interrupted strengthening proves nothing
+   if (res == UNKNOWN)
+      return false;
+
    if (res == UNSAT) {
       tmpNewClause = solver->getFinalAnalysis();
-   } else if (res == SAT) {
+   } else {
       tmpNewClause = solver->getSatAssumptions();
+
+      // Only a refutation without assumption derives the empty clause
+      if (tmpNewClause.empty())
+         return false;
    }
 
-   if (always_share || tmpNewClause.size() < cls->size || res == SAT) {
+   if (alwaysShare || tmpNewClause.size() < cls->size || res == SAT) {
       *outCls = ClauseManager::allocClause(tmpNewClause.size());
       for (int idLit = 0; idLit < tmpNewClause.size(); idLit++) {
          (*outCls)->lits[idLit] = tmpNewClause[idLit];
@@ -163,49 +306,91 @@ Reducer::strengthened(ClauseExchange * cls,
          (*outCls)->lbd = (*outCls)->size;
       }
       if (res == SAT) {
+         // The solver takes its own reference
+         ClauseManager::increaseClause(*outCls);
          solver->addClause(*outCls);
       }
    }
    if (tmpNewClause.size() == 0)
       return true;
    bool cls_seen = filter.test_and_insert(tmpNewClause);
-   return (tmpNewClause.size() < cls->size || always_share) && !cls_seen;
+   bool share    = (tmpNewClause.size() < cls->size || alwaysShare) && !cls_seen;
+
+   // The clause is not exported
+   if (share == false && *outCls != NULL) {
+      ClauseManager::releaseClause(*outCls);
+      *outCls = NULL;
+   }
+
+   return share;
 }
 
 void
 Reducer::addClause(ClauseExchange * clause)
 {
-   solver->addClause(clause);
+   ClauseManager::increaseClause(clause, workers.size() - 1);
+
+   for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].solver->addClause(clause);
+   }
 }
 
-void
+int
 Reducer::addLearnedClause(ClauseExchange * clause)
 {
    if (clause->size == 1) {
-      solver->addLearnedClause(clause);
+      int dropped = 0;
+
+      ClauseManager::increaseClause(clause, workers.size() - 1);
+
+      for (size_t i = 0; i < workers.size(); i++) {
+         dropped += workers[i].solver->addLearnedClause(clause);
+      }
+
+      return dropped;
    } else {
-      clausesToImport.addClause(clause);
+      int dropped = clausesToImport.addClause(clause);
+      importCondition.signal();
+      return dropped;
    }
 }
 
 void
 Reducer::addClauses(const vector<ClauseExchange *> & clauses)
 {
-   solver->addClauses(clauses);
+   for (size_t i = 0; i < clauses.size(); i++) {
+      addClause(clauses[i]);
+   }
 }
 
 void
-Reducer::addInitialClauses(const vector<ClauseExchange *> & clauses)
+Reducer::addInitialClauses(const vector<int> & lits, int nVars)
 {
-   solver->addInitialClauses(clauses);
+   for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].solver->addInitialClauses(lits, nVars);
+   }
 }
 
-void
+int
 Reducer::addLearnedClauses(const vector<ClauseExchange *> & clauses)
 {
+   int dropped = 0;
+   bool signal = false;
+
    for (size_t i = 0; i < clauses.size(); i++) {
-      addLearnedClause(clauses[i]);
+      if (clauses[i]->size == 1) {
+         dropped += addLearnedClause(clauses[i]);
+      } else {
+         dropped += clausesToImport.addClause(clauses[i]);
+         signal   = true;
+      }
    }
+
+   // Wake up a worker once for the whole batch
+   if (signal)
+      importCondition.signal();
+
+   return dropped;
 }
 
 void
@@ -217,50 +402,76 @@ Reducer::getLearnedClauses(vector<ClauseExchange *> & clauses)
 void
 Reducer::increaseClauseProduction()
 {
-   solver->increaseClauseProduction();
+   for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].solver->increaseClauseProduction();
+   }
 }
 
 void
 Reducer::decreaseClauseProduction()
 {
-   solver->decreaseClauseProduction();
+   for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].solver->decreaseClauseProduction();
+   }
 }
 
 SolvingStatistics
 Reducer::getStatistics()
 {
-   return solver->getStatistics();
+   SolvingStatistics stats;
+
+   for (size_t i = 0; i < workers.size(); i++) {
+      SolvingStatistics other = workers[i].solver->getStatistics();
+
+      stats.propagations += other.propagations;
+      stats.decisions    += other.decisions;
+      stats.conflicts    += other.conflicts;
+      stats.restarts     += other.restarts;
+      stats.memPeak      += other.memPeak;
+   }
+
+   return stats;
 }
 
 void
 Reducer::printStatsStrengthening()
 {
-   // log(0, "count,min,max,average,stdDeviation,sum\n");
-   // log(0, "cls_in,%s\n", cls_in.valueString().c_str());
-   // log(0, "cls_out,%s\n", cls_out.valueString().c_str());
-   // log(0, "strengthened,%s\n", strengthened.valueString().c_str());
+   for (size_t i = 0; i < workers.size(); i++) {
+      ReducerWorker & worker = workers[i];
+      double total           = worker.busyTime + worker.idleTime;
+
+      log(1, "Reducer %d worker %zu: %lu clauses reduced, %lu strengthened, " \
+          "busy %.2fs, idle %.2fs (%.1f%% busy)\n", id, i, worker.nReduced,
+          worker.nStrengthened, worker.busyTime, worker.idleTime,
+          total > 0 ? 100 * worker.busyTime / total : 0);
+   }
+
+   log(1, "Reducer %d filter: %lu generation changes, %lu clauses in the " \
+       "current generation, estimated false positive rate %.4f\n", id,
+       filter.getRotations(), filter.getInserted(),
+       filter.estimateFalsePositiveRate());
 }
 
 vector<int>
 Reducer::getModel()
 {
-   return solver->getModel();
+   return workers[0].solver->getModel();
 }
 
 vector<int>
 Reducer::getFinalAnalysis()
 {
-   return solver->getFinalAnalysis();
+   return workers[0].solver->getFinalAnalysis();
 }
 
 vector<int>
 Reducer::getSatAssumptions()
 {
-   return solver->getSatAssumptions();
+   return workers[0].solver->getSatAssumptions();
 }
 
 bool
 Reducer::testStrengthening()
 {
    return true;
-}
\ No newline at end of file
+}
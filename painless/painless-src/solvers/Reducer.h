@@ -34,7 +34,33 @@ namespace MapleCOMSPS
    template<class T> class vec;
 }
 
-/// Instance of a MapleCOMSPS solver
+class Reducer;
+
+/// A strengthening worker of a reducer, it owns its solver.
+struct ReducerWorker
+{
+   /// Reducer of the worker.
+   Reducer * reducer;
+
+   /// Solver used to strengthen the clauses.
+   SolverInterface * solver;
+
+   /// Thread of the worker, NULL for the thread calling solve.
+   Thread * thread;
+
+   /// Time spent waiting for clauses and reducing clauses, in seconds.
+   double idleTime;
+   double busyTime;
+
+   /// Number of reduced and strengthened clauses.
+   unsigned long nReduced;
+   unsigned long nStrengthened;
+};
+
+/// Pool of strengthening workers, seen as a single solver by the sharers.
+/// The workers take chunks of clauses from a shared import buffer, so a
+/// worker never idles while clauses are waiting, and share one filter of
+/// the strengthened clauses.
 class Reducer : public SolverInterface
 {
 public:
@@ -59,9 +85,8 @@ public:
    /// Remove the SAT solving interrupt request.
    void unsetSolverInterrupt();
 
-   /// Solve the formula with a given cube.
-   SatResult solve_(const vector<int> & cube);
-
+   /// Strengthen the imported clauses with all the workers until
+   /// interrupted or the empty clause is derived.
    SatResult solve(const vector<int> & cube);
 
    /// Add a permanent clause to the formula.
@@ -71,13 +96,13 @@ public:
    void addClauses(const vector<ClauseExchange *> & clauses);
    
    /// Add a list of initial clauses to the formula.
-   void addInitialClauses(const vector<ClauseExchange *> & clauses);
+   void addInitialClauses(const vector<int> & lits, int nVars);
 
    /// Add a learned clause to the formula.
-   void addLearnedClause(ClauseExchange * clause);
+   int addLearnedClause(ClauseExchange * clause);
    
    /// Add a list of learned clauses to the formula.
-   void addLearnedClauses(const vector<ClauseExchange *> & clauses);
+   int addLearnedClauses(const vector<ClauseExchange *> & clauses);
 
    /// Get a list of learned clauses.
    void getLearnedClauses(vector<ClauseExchange *> & clauses);
@@ -100,7 +125,10 @@ public:
    /// Native diversification.
    void diversify(int id);
 
-   bool strengthened(ClauseExchange * cls, ClauseExchange ** outCls);
+   /// Strengthen a clause with the solver of a worker, return true if the
+   /// strengthened clause in outCls has to be shared.
+   bool strengthened(SolverInterface * solver, ClauseExchange * cls,
+                     ClauseExchange ** outCls);
 
    void printStatsStrengthening();
 
@@ -108,22 +136,47 @@ public:
 
    bool testStrengthening();
 
-   /// Constructor.
-   Reducer(int id, SolverInterface* solver);
+   /// Main loop of a worker.
+   void work(ReducerWorker * worker);
+
+   /// Constructor, the reducer takes the ownership of the solvers.
+   Reducer(int id, const vector<SolverInterface *> & solvers);
    
    /// Destructor.
    virtual ~Reducer();
 
 protected:
-   /// Pointer to a MapleCOMSPS solver.
-   SolverInterface * solver;
+   /// Workers of the reducer, one per MapleCOMSPS solver.
+   vector<ReducerWorker> workers;
 
-   /// Buffer used to import clauses (units included).
+   /// Buffer used to import clauses (units included), shared by the workers.
    ClauseBuffer clausesToImport;
 
+   /// Condition signaled when clauses are imported or on interruption, a
+   /// woken worker passes the signal on while work remains.
+   Condition importCondition;
+
+   /// Is the reducer interrupted.
+   atomic<bool> interrupted;
+
+   /// Has the empty clause been derived.
+   atomic<bool> unsat;
+
+   /// Maximal time in useconds to wait for clauses before checking again.
+   int waitTime;
+
+   /// Number of clauses taken at once by a worker.
+   int chunkSize;
+
+   /// Are all the reduced clauses shared, even if not strengthened.
+   bool alwaysShare;
+
    /// Buffer used to export clauses (units included).
    ClauseBuffer clausesToExport;
 
-   BloomFilter filter;
+   /// Mutex protecting the export accounting of the workers.
+   Mutex exportLock;
 
+   /// Filter of the strengthened clauses, shared by the workers.
+   BloomFilter filter;
 };
@@ -22,21 +22,59 @@
 #include "../solvers/Kissat.h"
 #include "../solvers/SolverFactory.h"
 #include "../solvers/Reducer.h"
+#include "../utils/Logger.h"
 #include "../utils/Parameters.h"
 #include "../utils/System.h"
+#include "../utils/ThreadPool.h"
+
+#include <unistd.h>
+
+Formula * SolverFactory::formula = NULL;
+
+const Formula &
+SolverFactory::getFormula()
+{
+   if (formula != NULL)
+      return *formula;
+
+   double start = getRelativeTime();
+   int nThreads = Parameters::getIntParam("parse-threads",
+                                          sysconf(_SC_NPROCESSORS_ONLN));
+
+   formula = new Formula();
+
+   if (formula->load(Parameters::getFilename(), nThreads) == false) {
+      log(0, "Cannot read the formula %s\n", Parameters::getFilename());
+      exit(1);
+   }
+
+   log(1, "Formula: %d variables, %d clauses, parsed in %.2f s with %d " \
+       "threads\n", formula->nVars, formula->nClauses,
+       getRelativeTime() - start, nThreads);
+
+   return *formula;
+}
+
+void
+SolverFactory::releaseFormula()
+{
+   delete formula;
+   formula = NULL;
+}
 
 void
 SolverFactory::sparseRandomDiversification(
-      const vector<SolverInterface *> & solvers)
+      const vector<SolverInterface *> & solvers, int offset)
 {
    if (solvers.size() == 0)
       return;
 
    int vars = solvers[0]->getVariablesCount();
 
-   // The first solver of the group (1 LRB/1 VSIDS) keeps polarity = false for all vars
-   for (int sid = 1; sid < solvers.size(); sid++) {
-      srand(sid);
+   // The first solver of the group (1 LRB/1 VSIDS) keeps polarity = false for
+   // all vars, unless shifted by an offset
+   for (int sid = (offset > 0 ? 0 : 1); sid < solvers.size(); sid++) {
+      srand(sid + offset);
       for (int var = 1; var <= vars; var++) {
          if (rand() % solvers.size() == 0) {
             solvers[sid]->setPhase(var, rand() % 2 == 1);
@@ -46,10 +84,11 @@ SolverFactory::sparseRandomDiversification(
 }
 
 void
-SolverFactory::nativeDiversification(const vector<SolverInterface *> & solvers)
+SolverFactory::nativeDiversification(const vector<SolverInterface *> & solvers,
+                                     int offset)
 {
    for (int sid = 0; sid < solvers.size(); sid++) {
-      solvers[sid]->diversify(sid);
+      solvers[sid]->diversify(sid + offset);
    }
 }
 
@@ -60,7 +99,7 @@ SolverFactory::createMapleCOMSPSSolver()
 
    SolverInterface * solver = new MapleCOMSPSSolver(id);
 
-   solver->loadFormula(Parameters::getFilename());
+   solver->addInitialClauses(getFormula().lits, getFormula().nVars);
 
    return solver;
 }
@@ -72,17 +111,29 @@ SolverFactory::createMapleChronoBTSolver()
 
    SolverInterface * solver = new MapleChronoBTSolver(id);
 
-   solver->loadFormula(Parameters::getFilename());
+   solver->addInitialClauses(getFormula().lits, getFormula().nVars);
 
    return solver;
 }
 
 SolverInterface *
-SolverFactory::createReducerSolver(SolverInterface* _solver)
+SolverFactory::createReducerSolver(int nWorkers, const string & solverName)
 {
+   vector<SolverInterface *> workers;
+
+   if (solverName.compare("k") == 0) {
+      createKissatSolvers(nWorkers, workers);
+   } else {
+      workers.push_back(createMapleCOMSPSSolver());
+
+      for (int i = 1; i < nWorkers; i++) {
+         workers.push_back(cloneSolver(workers[0]));
+      }
+   }
+
    int id = currentIdSolver.fetch_add(1);
 
-   SolverInterface * solver = new Reducer(id, _solver);
+   SolverInterface * solver = new Reducer(id, workers);
 
    return solver;
 }
@@ -120,11 +171,24 @@ void
 SolverFactory::createKissatSolvers(int nbSolvers,
                                    vector<SolverInterface *> & solvers)
 {
-   for (size_t i = 0; i < nbSolvers; i++)
-   {
-      Kissat * kissat = (Kissat*) createKissatSolver();
-      solvers.push_back(kissat);
-   }
+   if (nbSolvers <= 0)
+      return;
+
+   // The solvers are built in parallel from the parsed formula, with the
+   // ids in the order of the solvers
+   const Formula & cnf = getFormula();
+
+   int firstId  = currentIdSolver.fetch_add(nbSolvers);
+   size_t begin = solvers.size();
+
+   solvers.resize(begin + nbSolvers);
+
+   ThreadPool pool(nbSolvers - 1);
+
+   pool.parallelFor(nbSolvers, [&](int i) {
+      solvers[begin + i] = new Kissat(firstId + i);
+      solvers[begin + i]->addInitialClauses(cnf.lits, cnf.nVars);
+   });
 }
 
 SolverInterface *
@@ -134,7 +198,7 @@ SolverFactory::createKissatSolver()
 
    SolverInterface *solver = new Kissat(id);
 
-   solver->loadFormula(Parameters::getFilename());
+   solver->addInitialClauses(getFormula().lits, getFormula().nVars);
    return solver;
 }
 
@@ -20,7 +20,9 @@
 #pragma once
 
 #include "../solvers/SolverInterface.h"
+#include "../utils/Formula.h"
 
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -31,6 +33,13 @@ static atomic<int> currentIdSolver(0);
 class SolverFactory
 {
 public:
+   /// Return the formula of the input file, parsed at the first call and
+   /// loaded by every created solver.
+   static const Formula & getFormula();
+
+   /// Free the parsed formula once the solvers are created.
+   static void releaseFormula();
+
    /// Instantiate and return a MapleCOMSPS solver.
    static SolverInterface * createMapleCOMSPSSolver();
 
@@ -50,7 +59,10 @@ public:
    static void createKissatSolvers(int groupSize,
                                    vector<SolverInterface *> & solvers);
 
-   static SolverInterface * createReducerSolver(SolverInterface *solver);
+   /// Instantiate and return a reducer with a given number of strengthening
+   /// workers, each with its own MapleCOMSPS (m) or Kissat (k) solver.
+   static SolverInterface * createReducerSolver(int nWorkers,
+                                                const string & solverName);
 
    /// Clone and return a new solver.
    static SolverInterface * cloneSolver(SolverInterface * other);
@@ -58,10 +70,18 @@ public:
    /// Print stats of a groupe of solvers.
    static void printStats(const vector<SolverInterface *> & solvers);
 
-   /// Apply a sparse and random diversification on solvers.
+   /// Apply a sparse and random diversification on solvers, the seeds are
+   /// shifted by an offset (e.g. for several processes).
    static void sparseRandomDiversification(const
-                                           vector<SolverInterface *> & solvers);
+                                           vector<SolverInterface *> & solvers,
+                                           int offset = 0);
+
+   /// Apply a native diversification on solvers, the ids are shifted by an
+   /// offset.
+   static void nativeDiversification(const vector<SolverInterface *> & solvers,
+                                     int offset = 0);
 
-   /// Apply a native diversification on solvers.
-   static void nativeDiversification(const vector<SolverInterface *> & solvers);
+protected:
+   /// Formula of the input file, NULL if not parsed.
+   static Formula * formula;
 };
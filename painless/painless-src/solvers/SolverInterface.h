@@ -19,7 +19,13 @@
 
 #pragma once
 
+#include "../clauses/ClauseBuffer.h"
 #include "../clauses/ClauseExchange.h"
+#include "../clauses/ClauseLog.h"
+#include "../sharing/ExportSignal.h"
+#include "../utils/LatencyHistogram.h"
+#include "../utils/Parameters.h"
+#include "../utils/System.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -108,14 +114,17 @@ public:
    /// Add a list of permanent clauses to the formula.
    virtual void addClauses(const vector<ClauseExchange *> & clauses) = 0;
 
-   /// Add a list of initial clauses to the formula.
-   virtual void addInitialClauses(const vector<ClauseExchange *> & clauses) = 0;
+   /// Add the initial clauses of the formula, given as a flat array of
+   /// literals where each clause ends with a zero, over nVars variables.
+   virtual void addInitialClauses(const vector<int> & lits, int nVars) = 0;
 
    /// Add a learned clause to the formula.
-   virtual void addLearnedClause(ClauseExchange * clauses) = 0;
+   /// @return the number of clauses dropped by the import buffers.
+   virtual int addLearnedClause(ClauseExchange * clauses) = 0;
    
    /// Add a list of learned clauses to the formula.
-   virtual void addLearnedClauses(const vector<ClauseExchange *> & clauses) = 0;
+   /// @return the number of clauses dropped by the import buffers.
+   virtual int addLearnedClauses(const vector<ClauseExchange *> & clauses) = 0;
 
    /// Get a list of learned clauses.
    virtual void getLearnedClauses(vector<ClauseExchange *> & clauses) = 0;
@@ -144,12 +153,91 @@ public:
 
    virtual bool testStrengthening() { return false; }
 
+   /// Prepare the solver to solve the cubes of a divide and conquer search,
+   /// before its first resolution. Return false if not supported.
+   virtual bool setCubing(bool b) { return false; }
+
+   /// Reallocate the memory of the solver from the calling thread, so that
+   /// the pages are first touched on its NUMA node. Called by the thread of
+   /// the solver before its first resolution.
+   virtual void localizeMemory() {}
+
+   /// Propagate a cube without search, then each literal of a list on top
+   /// of it. The number of variables assigned by the cube (-1 on conflict)
+   /// is put in assigned, and the number of variables assigned by each
+   /// literal (0 if already true, -1 on conflict) in counts.
+   /// Return false if not supported.
+   virtual bool lookahead(const vector<int> & cube, const vector<int> & lits,
+                          int & assigned, vector<int> & counts)
+   {
+      return false;
+   }
+
+   /// Return the number of occurrences of each variable (from 1) in the
+   /// clauses of the formula, empty if not supported.
+   virtual vector<int> getOccurrences() { return vector<int>(); }
+
+   /// Subscribe to a broadcast clause log, the solver will then import the
+   /// learned clauses appended to it. Return false if not supported, clauses
+   /// must then be given with addLearnedClause(s).
+   virtual bool subscribeClauseLog(ClauseLog * log) { return false; }
+
+   /// Unsubscribe from the clause logs, called by the thread of the solver
+   /// once it stops solving.
+   virtual void unsubscribeClauseLogs() {}
+
+   /// Set the signal of the sharer of the clauses exported by this solver.
+   void setExportSignal(ExportSignal * signal)
+   {
+      exportSignal = signal;
+   }
+
+   /// Timestamp an exported clause, add it to the export buffer and wake up
+   /// the sharer if needed.
+   /// Must be called by the thread of the solver.
+   void exportClause(ClauseBuffer & buffer, ClauseExchange * cls)
+   {
+      int size = cls->size;
+      int lbd  = cls->lbd;
+
+      cls->exportTime = getRelativeTime();
+
+      // The clause may be consumed as soon as it is added
+      buffer.addClause(cls);
+
+      ExportSignal * signal = exportSignal.load(memory_order_relaxed);
+
+      if (signal == NULL)
+         return;
+
+      exportedLiterals += size;
+
+      if (exportedLiterals >= signal->wakeLiterals ||
+          lbd <= signal->wakeLbd || signal->idle)
+      {
+         exportedLiterals = 0;
+         signal->notify();
+      }
+   }
+
+   /// Record the latency between the export and the import of a clause.
+   /// Must be called by the thread of the solver.
+   void recordImport(ClauseExchange * cls)
+   {
+      if (cls->exportTime > 0)
+         importLatency.record(getRelativeTime() - cls->exportTime);
+   }
+
    /// Constructor.
    SolverInterface(int solverId, SolverType solverType)
    {
       id    = solverId;
       type  = solverType;
       nRefs = 1;
+
+      exportSignal     = NULL;
+      exportedLiterals = 0;
+      unitCursor       = 0;
    }
 
    /// Destructor.
@@ -181,4 +269,30 @@ public:
 
    /// Number of references pointing on this solver.
    atomic<int> nRefs;
+
+   /// Latencies between the export and the import of the imported clauses.
+   LatencyHistogram importLatency;
+
+protected:
+   /// Bound the import buffers of the solver with the imp-cls-max,
+   /// imp-unit-max and imp-policy parameters, units may be NULL.
+   void initImportLimits(ClauseBuffer & clauses, ClauseBuffer * units)
+   {
+      OverflowPolicy policy = ClauseBuffer::parsePolicy(
+         Parameters::getParam("imp-policy", "oldest"));
+
+      clauses.setLimit(Parameters::getIntParam("imp-cls-max", 0), policy);
+
+      if (units != NULL)
+         units->setLimit(Parameters::getIntParam("imp-unit-max", 0), policy);
+   }
+
+   /// Signal of the sharer of the exported clauses, NULL if none.
+   atomic<ExportSignal *> exportSignal;
+
+   /// Number of literals exported since the last notification.
+   int exportedLiterals;
+
+   /// Position of the next unit to import from the unit channel.
+   int unitCursor;
 };
@@ -1,57 +1,191 @@
-#include <utils/BloomFilter.h>
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
 
-/* Lock-free concurrent Bloom Filter implementation */
+#include "../utils/BloomFilter.h"
+#include "../utils/ClauseHash.h"
 
-size_t BloomFilter::get_index(size_t bit) const
+#include <math.h>
+#include <new>
+#include <stdlib.h>
+
+BloomFilter::BloomFilter(int logBits, int nHashes_)
+{
+   size_t nWords = (1ULL << logBits) / 64;
+
+   if (nWords < BLOOM_BLOCK_WORDS)
+      nWords = BLOOM_BLOCK_WORDS;
+
+   for (int g = 0; g < 2; g++) {
+      void * mem;
+
+      if (posix_memalign(&mem, 64, nWords * sizeof(atomic<uint64_t>)) != 0)
+         throw bad_alloc();
+
+      words[g] = (atomic<uint64_t> *)mem;
+
+      for (size_t i = 0; i < nWords; i++) {
+         new (&words[g][i]) atomic<uint64_t>(0);
+      }
+
+      inserted[g] = 0;
+   }
+
+   nHashes   = nHashes_ > 0 ? nHashes_ : 1;
+   mask      = nWords / BLOOM_BLOCK_WORDS - 1;
+   nBits     = nWords * 64.0;
+   current   = 0;
+   rotating  = false;
+   rotations = 0;
+
+   // With k * n = m / 4 the false positive rate of a generation stays low,
+   // about 0.24% with 4 hashes
+   capacity = nWords * 64 / (4 * nHashes);
+}
+
+BloomFilter::~BloomFilter()
+{
+   free(words[0]);
+   free(words[1]);
+}
+
+bool
+BloomFilter::testBits(int generation, uint64_t hash, bool set)
+{
+   atomic<uint64_t> * block = words[generation] +
+                              (hash & mask) * BLOOM_BLOCK_WORDS;
+
+   // Double hashing in the block, the step is odd to visit distinct bits
+   uint32_t pos  = (uint32_t)(hash >> 32);
+   uint32_t step = (uint32_t)(mixHash64(hash) >> 32) | 1;
+   bool found    = true;
+
+   for (int i = 0; i < nHashes; i++, pos += step) {
+      uint32_t bit  = pos % BLOOM_BLOCK_BITS;
+      uint64_t flag = 1ULL << (bit % 64);
+      uint64_t old;
+
+      if (set) {
+         old = block[bit / 64].fetch_or(flag, memory_order_relaxed);
+      } else {
+         old = block[bit / 64].load(memory_order_relaxed);
+      }
+
+      if ((old & flag) == 0) {
+         found = false;
+
+         if (set == false)
+            return false;
+      }
+   }
+
+   return found;
+}
+
+void
+BloomFilter::rotate()
 {
-   //std::cout << "->"<< bit << " " << BITS_PER_ELEMENT << (bit / BITS_PER_ELEMENT) << std::endl;
-   return bit / BITS_PER_ELEMENT;
+   int cur = current.load(memory_order_relaxed);
+
+   if (inserted[cur].load(memory_order_relaxed) < capacity)
+      return;
+
+   bool expected = false;
+
+   if (rotating.compare_exchange_strong(expected, true) == false)
+      return;
+
+   // Late insertions in the cleared words may be lost, the filter only
+   // forgets clauses
+   int old       = 1 - cur;
+   size_t nWords = (mask + 1) * BLOOM_BLOCK_WORDS;
+
+   for (size_t i = 0; i < nWords; i++) {
+      words[old][i].store(0, memory_order_relaxed);
+   }
+
+   inserted[old] = 0;
+   current.store(old);
+   rotations++;
+
+   rotating = false;
 }
 
-size_t BloomFilter::get_mask(size_t bit) const
+void
+BloomFilter::insert(const vector<int> & clause)
 {
-   //std::cout << bit << " " << BITS_PER_ELEMENT << " " << ((bit % BITS_PER_ELEMENT)) << std::endl;
-   return 1L << (bit % BITS_PER_ELEMENT);
+   uint64_t hash = hashClause(clause.data(), clause.size());
+   int cur       = current.load();
+
+   testBits(cur, hash, true);
+   inserted[cur]++;
+
+   rotate();
 }
 
-void BloomFilter::set(size_t bit)
+bool
+BloomFilter::test_and_insert(const vector<int> & clause)
 {
-   // bits_[get_index(bit)] |= get_mask(bit);
-   auto tmp = get_mask(bit);
-   bits_[get_index(bit)] |= tmp;
+   uint64_t hash = hashClause(clause.data(), clause.size());
+   int cur       = current.load();
+
+   if (testBits(cur, hash, true))
+      return true;
+
+   inserted[cur]++;
+
+   bool found = testBits(1 - cur, hash, false);
+
+   rotate();
+
+   return found;
 }
 
-bool BloomFilter::test(size_t bit) const
+bool
+BloomFilter::contains(const vector<int> & clause)
 {
-   // return bits_[get_index(bit)] & get_mask(bit);
-   // std::cout << get_mask(bit) << " " << get_index(bit) << std::endl;
-   return bits_[get_index(bit)] & get_mask(bit);
+   uint64_t hash = hashClause(clause.data(), clause.size());
+
+   return testBits(0, hash, false) || testBits(1, hash, false);
 }
 
-void BloomFilter::insert(vector<int>& clause)
+double
+BloomFilter::estimateRate(int generation)
 {
-   for (const auto& f : hash_functions_)
-   {
-      hash_t hash = f(clause) % mem_size_bits_;
-      set(hash);
-   }
+   double n = inserted[generation].load(memory_order_relaxed);
+
+   return pow(1 - exp(-nHashes * n / nBits), nHashes);
 }
 
-bool BloomFilter::test_and_insert(vector<int>& clause) {
-   hash_t hash = hash_functions_[0](clause) % mem_size_bits_;
-   bool res = test(hash);
-   if (!res)
-      set(hash);
-   return res;
+double
+BloomFilter::estimateFalsePositiveRate()
+{
+   return 1 - (1 - estimateRate(0)) * (1 - estimateRate(1));
 }
 
-bool BloomFilter::contains(vector<int>& clause)
+unsigned long
+BloomFilter::getInserted()
 {
-   for (const auto& f : hash_functions_)
-   {
-      hash_t hash = f(clause) % mem_size_bits_;
-      if (!test(hash))
-         return false;
-   }
-   return true;
-}
\ No newline at end of file
+   return inserted[current.load()];
+}
+
+unsigned long
+BloomFilter::getRotations()
+{
+   return rotations;
+}
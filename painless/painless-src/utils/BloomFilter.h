@@ -1,103 +1,106 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
 #pragma once
 
 #include <atomic>
-#include <climits>
-#include <stdexcept>
+#include <stdint.h>
 #include <vector>
-#include <cmath>
-#include <iostream>
-#include <algorithm>
-#include "utils/hashfunc.h"
-// #include <spot/misc/clz.hh>
 
 using namespace std;
-#define NUM_BITS 67108864 // 8MB
-
-typedef size_t hash_t;
-typedef hash_t (*hash_function_t)(vector<int>&);
-typedef std::vector<hash_function_t> hash_functions_t;
-
-///Jenkins lookup3 hash function.
-///
-/// https://burtleburtle.net/bob/c/lookup3.c
-#define _jenkins_rot(x, k) (((x)<<(k)) | ((x)>>(32-(k))))
-
-inline hash_t lookup3_hash(hash_t key) {
-   size_t s1, s2;
-    s1 = s2 = 0xdeadbeef;
-    s2  ^= s1;
-    s2  -= _jenkins_rot(s1, 14);
-    key ^= s2;
-    key -= _jenkins_rot(s2, 11);
-    s1  ^= key;
-    s1  -= _jenkins_rot(key, 25);
-    s2  ^= s1;
-    s2  -= _jenkins_rot(s1, 16);
-    key ^= s2;
-    key -= _jenkins_rot(s2, 4);
-    s1  ^= key;
-    s1  -= _jenkins_rot(key, 14);
-    s2  ^= s1;
-    s2  -= _jenkins_rot(s1, 24);
-
-    return s2;
-}
-
-inline hash_t lookup3_hash_clause(vector<int>& clause) {
-  if (clause.size() == 0)
-    return 0;
-  std::sort(clause.begin(), clause.end());
-  hash_t hash = lookup3_hash(clause[0]);
-  for (int i = 1; i < clause.size(); i++) {
-    hash ^= lookup3_hash(clause[i]);
-  }
-  return hash;
-}
-
-/* Lock-free concurrent Bloom Filter implementation */
+
+/// Number of 64 bits words of a block of the filter, a block is a cache line.
+#define BLOOM_BLOCK_WORDS 8
+
+/// Number of bits of a block.
+#define BLOOM_BLOCK_BITS (BLOOM_BLOCK_WORDS * 64)
+
+/// Lock-free concurrent blocked Bloom filter of clauses.
+/// The k bits of a clause are in a single block selected by the clause hash
+/// and derived from it by double hashing, they are set with atomic or.
+/// The filter has two generations: clauses are inserted in the current one
+/// and tested in both, when the current generation is full the oldest one
+/// is cleared and becomes the current one. So the filter does not saturate,
+/// clauses inserted two generations ago are forgotten.
 class BloomFilter
 {
-   private:
-      size_t mem_size_;
-      size_t mem_size_bits_;
-      hash_functions_t hash_functions_;
-
-      /* Internal concurrent bitset */
-      static const size_t BITS_PER_ELEMENT = sizeof(uint64_t) * CHAR_BIT;
-
-      uint64_t *bits_;
-      size_t get_index(size_t bit) const;
-      size_t get_mask(size_t bit) const;
-      void set(size_t bit);
-      bool test(size_t bit) const;
-
-   public:
-
-
-      BloomFilter(size_t mem_size, hash_functions_t hash_functions)
-         : mem_size_( mem_size ),
-                  //std::pow(2, std::ceil(std::log(mem_size)/std::log(2)))),
-         mem_size_bits_(mem_size * BITS_PER_ELEMENT),
-         hash_functions_(hash_functions)
-      {
-        // std::cout << "BF: size " << mem_size_ << " "<< mem_size << std::endl;
-        bits_ = new uint64_t[mem_size_]{0};
-        if (hash_functions.empty())
-          throw std::invalid_argument("Bloom filter has no hash functions");
-      }
-
-      // Default internal hash function
-      BloomFilter(size_t mem_size)
-        : BloomFilter(mem_size, {lookup3_hash_clause}) { }
-
-      BloomFilter()
-        : BloomFilter(NUM_BITS) {}
-
-      ~BloomFilter()
-      {
-        delete[] bits_;
-      }
-      void insert(vector<int>& clause);
-      bool test_and_insert(vector<int>& clause);
-      bool contains(vector<int>& clause);
-};
\ No newline at end of file
+public:
+   /// Constructor, each generation has 2^logBits bits.
+   BloomFilter(int logBits = 25, int nHashes = 4);
+
+   /// Destructor.
+   ~BloomFilter();
+
+   /// Insert a clause.
+   void insert(const vector<int> & clause);
+
+   /// Test if a clause may have been inserted, insert it otherwise.
+   bool test_and_insert(const vector<int> & clause);
+
+   /// Test if a clause may have been inserted.
+   bool contains(const vector<int> & clause);
+
+   /// Return the estimated false positive rate of the filter.
+   double estimateFalsePositiveRate();
+
+   /// Return the number of insertions in the current generation.
+   unsigned long getInserted();
+
+   /// Return the number of generation changes.
+   unsigned long getRotations();
+
+protected:
+   /// Test the bits of a hash in a generation, set them if asked.
+   /// @return true if all the bits were set.
+   bool testBits(int generation, uint64_t hash, bool set);
+
+   /// Clear the oldest generation and make it the current one, if the
+   /// current one is full.
+   void rotate();
+
+   /// Estimated false positive rate of a generation.
+   double estimateRate(int generation);
+
+   /// Words of the two generations.
+   atomic<uint64_t> * words[2];
+
+   /// Number of insertions in each generation.
+   atomic<unsigned long> inserted[2];
+
+   /// Index of the current generation.
+   atomic<int> current;
+
+   /// Is a generation being cleared.
+   atomic<bool> rotating;
+
+   /// Number of generation changes.
+   atomic<unsigned long> rotations;
+
+   /// Number of blocks of a generation minus one.
+   uint64_t mask;
+
+   /// Number of bits of a generation.
+   double nBits;
+
+   /// Number of bits set per clause.
+   int nHashes;
+
+   /// Number of insertions before changing of generation.
+   unsigned long capacity;
+};
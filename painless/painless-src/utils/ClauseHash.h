@@ -0,0 +1,48 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+/// Mix the bits of a 64 bits value (finalizer of MurmurHash3).
+inline uint64_t mixHash64(uint64_t key)
+{
+   key ^= key >> 33;
+   key *= 0xff51afd7ed558ccdULL;
+   key ^= key >> 33;
+   key *= 0xc4ceb53fe1a85ec9ULL;
+   key ^= key >> 33;
+
+   return key;
+}
+
+/// Hash of a clause that does not depend on the order of its literals.
+/// The mixed literals are summed, so permutations give the same hash while
+/// two occurrences of a literal do not cancel each other as with a xor.
+inline uint64_t hashClause(const int * lits, int size)
+{
+   uint64_t hash = 0;
+
+   for (int i = 0; i < size; i++) {
+      hash += mixHash64((uint64_t)(int64_t)lits[i]);
+   }
+
+   return mixHash64(hash + size);
+}
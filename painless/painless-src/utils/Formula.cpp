@@ -0,0 +1,788 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../utils/Formula.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadPool.h"
+#include "../utils/Threading.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+using namespace std;
+
+/// Size of the blocks of a decoded gzip file.
+#define DECODED_BLOCK_SIZE (16 << 20)
+
+/// Maximal number of decoded blocks waiting to be parsed.
+#define DECODED_BLOCKS_MAX 4
+
+/// Magic number of the binary cache format, with its version.
+#define CACHE_MAGIC "PNLSCNF1"
+
+/// Number of clauses of a block of the binary cache format.
+#define CACHE_BLOCK_SIZE 4096
+
+/// Header of the binary cache format. It is followed by the index of the
+/// blocks, then by the encoded clauses: the size of each clause, then the
+/// difference of each literal code (2 * var + sign) with the previous one of
+/// the clause, zigzag and varint encoded. The hash combines the hashes of
+/// the encoded blocks.
+struct CacheHeader
+{
+   char     magic[8];
+   uint32_t nVars;
+   uint32_t blockSize;
+   uint64_t nClauses;
+   uint64_t nLits;
+   uint64_t nBlocks;
+   uint64_t dataSize;
+   uint64_t hash;
+};
+
+/// Entry of the index of the blocks, the offsets of the first clause of the
+/// block in the encoded clauses and in the literals.
+struct CacheBlock
+{
+   uint64_t byteOffset;
+   uint64_t litOffset;
+};
+
+/// Result of the parsing of a chunk.
+struct FormulaChunk
+{
+   /// Literals of the chunk, a clause may start in a previous chunk.
+   vector<int> lits;
+
+   /// Greatest variable of the clauses and of the header.
+   int maxVar;
+
+   /// Number of zeros of the chunk.
+   int nClauses;
+
+   /// Has the end marker been read.
+   bool ended;
+
+   /// Is the chunk valid.
+   bool valid;
+};
+
+/// Blocks of a gzip file decoded by a streaming thread.
+struct DecodedBlocks
+{
+   /// Decoded file.
+   gzFile in;
+
+   /// Blocks waiting to be parsed.
+   deque<vector<char> *> blocks;
+
+   /// Mutex protecting the blocks and the flags.
+   Mutex lock;
+
+   /// Signaled when a block is added or the decoding is done.
+   Condition filled;
+
+   /// Signaled when a block is taken or the decoding has to stop.
+   Condition freed;
+
+   /// Is the decoding done, has it failed.
+   bool done;
+   bool failed;
+
+   /// Is the decoding asked to stop.
+   atomic<bool> stop;
+};
+
+// Main of the thread decoding a gzip file
+static void *
+mainDecoder(void * arg)
+{
+   DecodedBlocks * dec = (DecodedBlocks *)arg;
+
+   bool failed = false;
+
+   while (dec->stop == false) {
+      vector<char> * block = new vector<char>(DECODED_BLOCK_SIZE);
+
+      int n = gzread(dec->in, block->data(), DECODED_BLOCK_SIZE);
+
+      if (n <= 0) {
+         failed = n < 0;
+         delete block;
+         break;
+      }
+
+      block->resize(n);
+
+      // A few blocks only wait for the parser
+      dec->lock.lock();
+
+      while (dec->blocks.size() >= DECODED_BLOCKS_MAX && dec->stop == false) {
+         dec->lock.unlock();
+         dec->freed.wait();
+         dec->lock.lock();
+      }
+
+      dec->blocks.push_back(block);
+      dec->lock.unlock();
+
+      dec->filled.signal();
+   }
+
+   dec->lock.lock();
+   dec->done   = true;
+   dec->failed = failed;
+   dec->lock.unlock();
+
+   dec->filled.signal();
+
+   return NULL;
+}
+
+// Length of the run of digits at the beginning of 8 bytes (little endian),
+// each byte being checked at once
+static inline int
+digitsLength(uint64_t x)
+{
+   const uint64_t ones = 0x0101010101010101ULL;
+   const uint64_t high = 0x8080808080808080ULL;
+
+   // The high bit of a byte is set if the byte is at least '0', resp. ':',
+   // the bytes are ASCII so the additions do not carry
+   uint64_t atLeastZero  = x + ones * (0x80 - '0');
+   uint64_t atLeastColon = x + ones * (0x80 - '9' - 1);
+   uint64_t nonDigits    = ~(atLeastZero & ~atLeastColon) & high;
+
+   return nonDigits ? __builtin_ctzll(nonDigits) / 8 : 8;
+}
+
+// Value of the first len digits of 8 bytes (little endian)
+static inline uint64_t
+digitsValue(uint64_t x, int len)
+{
+   // The digits are moved to the high bytes, the low bytes being leading
+   // zeros, then combined by pairs, quads and octets
+   x = (x - 0x3030303030303030ULL) << (8 * (8 - len));
+   x = (x * 10) + (x >> 8);
+   x = (((x & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+        (((x >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+
+   return x;
+}
+
+// FNV-1a hash of some bytes, taken by words of 8 bytes
+static uint64_t
+hashBytes(const unsigned char * p, size_t size)
+{
+   uint64_t h = 0xcbf29ce484222325ULL;
+   size_t i   = 0;
+
+   for (; i + 8 <= size; i += 8) {
+      uint64_t word;
+
+      memcpy(&word, p + i, 8);
+      h = (h ^ word) * 0x100000001b3ULL;
+   }
+
+   for (; i < size; i++) {
+      h = (h ^ p[i]) * 0x100000001b3ULL;
+   }
+
+   return h;
+}
+
+// Hash of the formula from the hashes of its blocks
+static uint64_t
+combineHashes(const vector<uint64_t> & hashes)
+{
+   uint64_t h = 0xcbf29ce484222325ULL;
+
+   for (size_t i = 0; i < hashes.size(); i++) {
+      h = (h ^ hashes[i]) * 0x100000001b3ULL;
+   }
+
+   return h;
+}
+
+static inline void
+writeVarint(vector<unsigned char> & out, uint64_t x)
+{
+   while (x >= 0x80) {
+      out.push_back((x & 0x7f) | 0x80);
+      x >>= 7;
+   }
+
+   out.push_back(x);
+}
+
+// Read a varint, return false if it does not end before the end
+static inline bool
+readVarint(const unsigned char *& p, const unsigned char * end, uint64_t & x)
+{
+   x = 0;
+
+   // Most of the values fit in a byte
+   if (p < end && (*p & 0x80) == 0) {
+      x = *p++;
+      return true;
+   }
+
+   for (int shift = 0; p < end && shift < 64; shift += 7) {
+      unsigned char b = *p++;
+
+      x |= (uint64_t)(b & 0x7f) << shift;
+
+      if ((b & 0x80) == 0)
+         return true;
+   }
+
+   return false;
+}
+
+// Decode a block of the binary cache format, return false if not valid
+static bool
+decodeBlock(const unsigned char * p, const unsigned char * end, int * out,
+            int * outEnd, uint64_t nClauses, int nVars)
+{
+   for (uint64_t i = 0; i < nClauses; i++) {
+      uint64_t size, z;
+
+      if (readVarint(p, end, size) == false ||
+          (uint64_t)(outEnd - out) < size + 1)
+         return false;
+
+      int64_t prev = 0;
+
+      for (uint64_t k = 0; k < size; k++) {
+         if (readVarint(p, end, z) == false)
+            return false;
+
+         int64_t code = prev + (int64_t)((z >> 1) ^ (~(z & 1) + 1));
+         int64_t var  = code >> 1;
+
+         if (var < 1 || var > nVars)
+            return false;
+
+         *out++ = (code & 1) ? -var : var;
+         prev   = code;
+      }
+
+      *out++ = 0;
+   }
+
+   return p == end && out == outEnd;
+}
+
+// Parse a chunk made of complete lines
+static void
+parseChunk(const char * p, const char * end, FormulaChunk & chunk)
+{
+   const uint64_t high = 0x8080808080808080ULL;
+
+   chunk.maxVar   = 0;
+   chunk.nClauses = 0;
+   chunk.ended    = false;
+   chunk.valid    = true;
+
+   while (p < end) {
+      char c = *p;
+
+      if (c == ' ' || c == '\n' || c == '\t' || c == '\r') {
+         p++;
+         continue;
+      }
+
+      // Comment or problem line
+      if (c == 'c' || c == 'p') {
+         const char * eol = (const char *)memchr(p, '\n', end - p);
+
+         if (eol == NULL)
+            eol = end;
+
+         if (c == 'p') {
+            int vars = 0, clauses = 0;
+
+            string line(p, eol);
+
+            if (sscanf(line.c_str(), "p cnf %d %d", &vars, &clauses) != 2) {
+               chunk.valid = false;
+               return;
+            }
+
+            chunk.maxVar = max(chunk.maxVar, vars);
+         }
+
+         p = eol;
+         continue;
+      }
+
+      // End marker of some benchmarks
+      if (c == '%') {
+         chunk.ended = true;
+         return;
+      }
+
+      bool neg = c == '-';
+
+      if (neg)
+         p++;
+
+      if (p == end || (unsigned)(*p - '0') > 9) {
+         chunk.valid = false;
+         return;
+      }
+
+      uint64_t value = 0;
+      uint64_t word;
+
+      // Up to 8 digits are read at once
+      if (end - p >= 8) {
+         memcpy(&word, p, 8);
+
+         if ((word & high) == 0) {
+            int len = digitsLength(word);
+
+            value = digitsValue(word, len);
+            p    += len;
+         }
+      }
+
+      while (p < end && (unsigned)(*p - '0') <= 9) {
+         value = value * 10 + (*p - '0');
+         p++;
+
+         if (value > INT_MAX)
+            break;
+      }
+
+      if (value > INT_MAX) {
+         chunk.valid = false;
+         return;
+      }
+
+      if (value == 0) {
+         chunk.lits.push_back(0);
+         chunk.nClauses++;
+      } else {
+         chunk.lits.push_back(neg ? -(int)value : (int)value);
+         chunk.maxVar = max(chunk.maxVar, (int)value);
+      }
+   }
+}
+
+Formula::Formula()
+{
+   nVars    = 0;
+   nClauses = 0;
+   pool     = NULL;
+   nChunks  = 1;
+   ended    = false;
+}
+
+bool
+Formula::load(const char * filename, int nThreads)
+{
+   nThreads = max(nThreads, 1);
+
+   int fd = open(filename, O_RDONLY);
+
+   if (fd < 0)
+      return false;
+
+   struct stat st;
+
+   if (fstat(fd, &st) != 0) {
+      close(fd);
+      return false;
+   }
+
+   // More chunks than threads balance the parsing
+   pool    = new ThreadPool(nThreads - 1);
+   nChunks = nThreads > 1 ? nThreads * 4 : 1;
+
+   unsigned char magic[8] = {0};
+   bool res = true;
+
+   if (st.st_size >= 2 && pread(fd, magic, 8, 0) >= 2 &&
+       magic[0] == 0x1f && magic[1] == 0x8b)
+   {
+      close(fd);
+      res = loadCompressed(filename);
+   } else if (st.st_size > 0) {
+      void * data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      close(fd);
+
+      if (data == MAP_FAILED) {
+         res = false;
+      } else {
+         madvise(data, st.st_size, MADV_WILLNEED);
+
+         if (memcmp(magic, CACHE_MAGIC, 8) == 0) {
+            res = loadBinary((const char *)data, st.st_size);
+         } else {
+            res = parse((const char *)data, (const char *)data + st.st_size);
+         }
+
+         munmap(data, st.st_size);
+      }
+   } else {
+      close(fd);
+   }
+
+   delete pool;
+   pool = NULL;
+
+   // The last clause may miss its zero
+   if (res && lits.empty() == false && lits.back() != 0) {
+      lits.push_back(0);
+      nClauses++;
+   }
+
+   return res;
+}
+
+bool
+Formula::save(const char * filename) const
+{
+   CacheHeader header;
+   vector<CacheBlock> index;
+   vector<uint64_t> hashes;
+   vector<unsigned char> data;
+
+   // The clauses are encoded block by block
+   size_t begin       = 0;
+   uint64_t inBlock   = 0;
+   uint64_t nEncoded  = 0;
+   CacheBlock block   = {0, 0};
+
+   for (size_t i = 0; i < lits.size(); i = begin) {
+      size_t end = i;
+
+      while (lits[end] != 0) {
+         end++;
+      }
+
+      writeVarint(data, end - i);
+
+      int64_t prev = 0;
+
+      for (size_t k = i; k < end; k++) {
+         int64_t code  = 2 * (int64_t)abs(lits[k]) + (lits[k] < 0);
+         int64_t delta = code - prev;
+
+         writeVarint(data, (uint64_t)((delta << 1) ^ (delta >> 63)));
+         prev = code;
+      }
+
+      begin = end + 1;
+      nEncoded++;
+
+      if (++inBlock == CACHE_BLOCK_SIZE || begin == lits.size()) {
+         hashes.push_back(hashBytes(data.data() + block.byteOffset,
+                                    data.size() - block.byteOffset));
+         index.push_back(block);
+
+         block.byteOffset = data.size();
+         block.litOffset  = begin;
+         inBlock          = 0;
+      }
+   }
+
+   index.push_back(block);
+
+   memcpy(header.magic, CACHE_MAGIC, 8);
+   header.nVars     = nVars;
+   header.blockSize = CACHE_BLOCK_SIZE;
+   header.nClauses  = nEncoded;
+   header.nLits     = lits.size();
+   header.nBlocks   = hashes.size();
+   header.dataSize  = data.size();
+   header.hash      = combineHashes(hashes);
+
+   FILE * out = fopen(filename, "wb");
+
+   if (out == NULL)
+      return false;
+
+   bool res = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              fwrite(index.data(), sizeof(CacheBlock), index.size(), out) ==
+                 index.size() &&
+              fwrite(data.data(), 1, data.size(), out) == data.size();
+
+   return fclose(out) == 0 && res;
+}
+
+uint64_t
+Formula::getHash() const
+{
+   uint64_t h = hashBytes((const unsigned char *)lits.data(),
+                          lits.size() * sizeof(int));
+
+   return (h ^ nVars) * 0x100000001b3ULL;
+}
+
+bool
+Formula::loadBinary(const char * data, size_t size)
+{
+   CacheHeader header;
+
+   if (size < sizeof(header))
+      return false;
+
+   memcpy(&header, data, sizeof(header));
+
+   // The index and the encoded clauses fill the rest of the file
+   size_t indexSize = (header.nBlocks + 1) * sizeof(CacheBlock);
+
+   if (header.nBlocks > size / sizeof(CacheBlock) ||
+       size != sizeof(header) + indexSize + header.dataSize ||
+       header.nVars > INT_MAX || header.nClauses > INT_MAX ||
+       header.blockSize == 0 ||
+       header.nLits > size * 8)
+   {
+      log(0, "Invalid binary formula\n");
+      return false;
+   }
+
+   vector<CacheBlock> index(header.nBlocks + 1);
+
+   memcpy(index.data(), data + sizeof(header), indexSize);
+
+   const unsigned char * encoded = (const unsigned char *)data +
+                                   sizeof(header) + indexSize;
+
+   for (size_t b = 0; b < header.nBlocks; b++) {
+      if (index[b].byteOffset > index[b + 1].byteOffset ||
+          index[b].litOffset > index[b + 1].litOffset)
+      {
+         log(0, "Invalid binary formula\n");
+         return false;
+      }
+   }
+
+   if (index[header.nBlocks].byteOffset != header.dataSize ||
+       index[header.nBlocks].litOffset != header.nLits)
+   {
+      log(0, "Invalid binary formula\n");
+      return false;
+   }
+
+   lits.resize(header.nLits);
+
+   // The blocks are decoded and hashed in parallel
+   vector<uint64_t> hashes(header.nBlocks);
+   atomic<bool> valid(true);
+
+   pool->parallelFor(header.nBlocks, [&](int b) {
+      const unsigned char * begin = encoded + index[b].byteOffset;
+      const unsigned char * end   = encoded + index[b + 1].byteOffset;
+
+      uint64_t nBlockClauses = b + 1 < (int)header.nBlocks ?
+         header.blockSize : header.nClauses - (uint64_t)b * header.blockSize;
+
+      hashes[b] = hashBytes(begin, end - begin);
+
+      if (decodeBlock(begin, end, lits.data() + index[b].litOffset,
+                      lits.data() + index[b + 1].litOffset, nBlockClauses,
+                      header.nVars) == false)
+      {
+         valid = false;
+      }
+   });
+
+   if (valid == false || combineHashes(hashes) != header.hash) {
+      log(0, "Corrupted binary formula\n");
+      lits.clear();
+      return false;
+   }
+
+   nVars    = header.nVars;
+   nClauses = header.nClauses;
+
+   return true;
+}
+
+bool
+Formula::loadCompressed(const char * filename)
+{
+   DecodedBlocks dec;
+
+   dec.in = gzopen(filename, "rb");
+
+   if (dec.in == NULL)
+      return false;
+
+   gzbuffer(dec.in, 1 << 20);
+
+   dec.done   = false;
+   dec.failed = false;
+   dec.stop   = false;
+
+   Thread * decoder = new Thread(mainDecoder, &dec);
+
+   // A line cut by the end of a block is completed with the next one
+   string carry;
+   bool res = true;
+
+   while (res && ended == false) {
+      dec.lock.lock();
+
+      while (dec.blocks.empty() && dec.done == false) {
+         dec.lock.unlock();
+         dec.filled.wait();
+         dec.lock.lock();
+      }
+
+      if (dec.blocks.empty()) {
+         res = dec.failed == false;
+         dec.lock.unlock();
+         break;
+      }
+
+      vector<char> * block = dec.blocks.front();
+      dec.blocks.pop_front();
+      dec.lock.unlock();
+
+      dec.freed.signal();
+
+      const char * begin = block->data();
+      const char * end   = begin + block->size();
+      const char * first = (const char *)memchr(begin, '\n', end - begin);
+
+      if (first == NULL) {
+         carry.append(begin, end);
+      } else {
+         const char * last = (const char *)memrchr(begin, '\n', end - begin);
+
+         carry.append(begin, first + 1);
+
+         res = parse(carry.data(), carry.data() + carry.size()) &&
+               parse(first + 1, last + 1);
+
+         carry.assign(last + 1, end);
+      }
+
+      delete block;
+   }
+
+   // The decoder is stopped if the parsing ends first
+   dec.stop = true;
+   dec.freed.signal();
+
+   decoder->join();
+   delete decoder;
+
+   for (size_t i = 0; i < dec.blocks.size(); i++) {
+      delete dec.blocks[i];
+   }
+
+   gzclose(dec.in);
+
+   if (res && ended == false) {
+      res = parse(carry.data(), carry.data() + carry.size());
+   }
+
+   return res;
+}
+
+bool
+Formula::parse(const char * begin, const char * end)
+{
+   if (begin == end || ended)
+      return true;
+
+   // The chunks start at the beginning of a line
+   vector<const char *> bounds;
+   size_t step = (end - begin) / nChunks + 1;
+
+   bounds.push_back(begin);
+
+   while (end - bounds.back() > step) {
+      const char * p   = bounds.back() + step;
+      const char * eol = (const char *)memchr(p, '\n', end - p);
+
+      if (eol == NULL || eol + 1 == end)
+         break;
+
+      bounds.push_back(eol + 1);
+   }
+
+   bounds.push_back(end);
+
+   int n = bounds.size() - 1;
+
+   vector<FormulaChunk> chunks(n);
+
+   pool->parallelFor(n, [&](int i) {
+      chunks[i].lits.reserve((bounds[i + 1] - bounds[i]) / 4);
+      parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+   });
+
+   // The chunks are appended in order, up to the end marker
+   vector<size_t> offsets(n);
+   size_t total = lits.size();
+
+   for (int i = 0; i < n; i++) {
+      if (chunks[i].valid == false) {
+         log(0, "Parse error in the formula\n");
+         return false;
+      }
+
+      offsets[i] = total;
+      total     += chunks[i].lits.size();
+      nVars      = max(nVars, chunks[i].maxVar);
+      nClauses  += chunks[i].nClauses;
+
+      if (chunks[i].ended) {
+         ended = true;
+         n     = i + 1;
+         break;
+      }
+   }
+
+   // A single chunk is kept as is
+   if (n == 1 && lits.empty()) {
+      lits.swap(chunks[0].lits);
+      return true;
+   }
+
+   lits.resize(total);
+
+   pool->parallelFor(n, [&](int i) {
+      if (chunks[i].lits.empty() == false) {
+         memcpy(&lits[offsets[i]], chunks[i].lits.data(),
+                chunks[i].lits.size() * sizeof(int));
+      }
+
+      vector<int>().swap(chunks[i].lits);
+   });
+
+   return true;
+}
@@ -0,0 +1,81 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+class ThreadPool;
+
+/// Formula of a DIMACS file, parsed once and shared by all the solver
+/// backends. The clauses are stored in a flat array of literals, each
+/// clause ended by a zero.
+/// A plain file is mapped in memory and split in chunks on line boundaries,
+/// the chunks being parsed in parallel. A gzip file is decoded by a
+/// streaming thread, the decoded blocks being parsed as they come. A file
+/// in the binary cache format written by save is mapped and decoded in
+/// parallel, without parsing.
+class Formula
+{
+public:
+   /// Constructor.
+   Formula();
+
+   /// Parse a DIMACS file with a given number of threads, return false if
+   /// the file cannot be read or is not valid.
+   bool load(const char * filename, int nThreads);
+
+   /// Write the formula in the binary cache format, return false if failed.
+   bool save(const char * filename) const;
+
+   /// Return a hash of the variables and clauses of the formula.
+   uint64_t getHash() const;
+
+   /// Number of variables, the maximum of the header and of the clauses.
+   int nVars;
+
+   /// Number of clauses.
+   int nClauses;
+
+   /// Literals of the clauses, each clause ended by a zero.
+   vector<int> lits;
+
+protected:
+   /// Decode a file in the binary cache format mapped in memory.
+   bool loadBinary(const char * data, size_t size);
+
+   /// Parse a gzip file decoded by a streaming thread.
+   bool loadCompressed(const char * filename);
+
+   /// Parse a text made of complete lines in parallel, the literals are
+   /// appended to the formula.
+   bool parse(const char * begin, const char * end);
+
+   /// Pool of threads parsing the chunks.
+   ThreadPool * pool;
+
+   /// Number of chunks of a text.
+   int nChunks;
+
+   /// Has the end marker (%) of the formula been read.
+   bool ended;
+};
@@ -0,0 +1,120 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../utils/Logger.h"
+
+#include <stdio.h>
+#include <string>
+
+using namespace std;
+
+/// Number of buckets of the histogram.
+#define LATENCY_BUCKETS 16
+
+/// Histogram of latencies, bucket i counts the latencies lower than 2^i ms
+/// (the last one counts all the remaining ones).
+/// It is updated by a single thread.
+struct LatencyHistogram
+{
+   /// Constructor.
+   LatencyHistogram()
+   {
+      for (int i = 0; i < LATENCY_BUCKETS; i++) {
+         buckets[i] = 0;
+      }
+
+      count = 0;
+      total = 0;
+   }
+
+   /// Record a latency in seconds.
+   void record(double latency)
+   {
+      double ms = latency * 1000;
+      int i     = 0;
+
+      while (i < LATENCY_BUCKETS - 1 && ms >= (1 << i)) {
+         i++;
+      }
+
+      buckets[i]++;
+      count++;
+      total += latency;
+   }
+
+   /// Add the values of another histogram.
+   void merge(const LatencyHistogram & other)
+   {
+      for (int i = 0; i < LATENCY_BUCKETS; i++) {
+         buckets[i] += other.buckets[i];
+      }
+
+      count += other.count;
+      total += other.total;
+   }
+
+   /// Return the latency in ms under which is a given ratio of the values.
+   int percentile(double ratio)
+   {
+      unsigned long seen = 0;
+
+      for (int i = 0; i < LATENCY_BUCKETS; i++) {
+         seen += buckets[i];
+
+         if (seen >= ratio * count)
+            return 1 << i;
+      }
+
+      return 1 << (LATENCY_BUCKETS - 1);
+   }
+
+   /// Print the histogram.
+   void print(int level, const char * name)
+   {
+      if (count == 0)
+         return;
+
+      string line;
+      char buffer[64];
+
+      for (int i = 0; i < LATENCY_BUCKETS; i++) {
+         if (buckets[i] == 0)
+            continue;
+
+         snprintf(buffer, sizeof(buffer), " <%dms:%lu", 1 << i, buckets[i]);
+         line += buffer;
+      }
+
+      log(level, "%s latency: %lu clauses, mean %.1fms, p50 <%dms, " \
+          "p99 <%dms\n", name, count, 1000 * total / count, percentile(0.5),
+          percentile(0.99));
+      log(level, "%s latency histogram:%s\n", name, line.c_str());
+   }
+
+   /// Number of values per bucket.
+   unsigned long buckets[LATENCY_BUCKETS];
+
+   /// Number of values.
+   unsigned long count;
+
+   /// Sum of the values in seconds.
+   double total;
+};
@@ -46,6 +46,10 @@ public:
             continue;
          }
 
+         // Long options (--name) are accepted as well
+         if (arg[1] == '-')
+            arg++;
+
          char * eq = strchr(arg, '=');
 
          if (eq == NULL) {
@@ -17,12 +17,13 @@
 // this program.  If not, see <http://www.gnu.org/licenses/>.
 // -----------------------------------------------------------------------------
 
+#include "../utils/Formula.h"
+#include "../utils/Parameters.h"
 #include "../utils/SatUtils.h"
-#include "../clauses/ClauseManager.h"
 
-#include <ctype.h>
 #include <stdio.h>
 #include <math.h>
+#include <unistd.h>
 
 static unsigned intWidth(int i)
 {
@@ -59,79 +60,14 @@ void printModel(vector<int> & model)
 bool loadFormulaToSolvers(vector<SolverInterface*> solvers,
                           const char* filename)
 {
-	FILE* f = fopen(filename, "r");
+	Formula formula;
 
-	if (f == NULL)
+	if (formula.load(filename, Parameters::getIntParam("parse-threads",
+	                 sysconf(_SC_NPROCESSORS_ONLN))) == false)
 		return false;
-	
-	int c    = 0;
-	bool neg = false;
-
-	vector<ClauseExchange *> clauses;
-
-	vector<int> cls;
-
-	while (c != EOF) {
-		c = fgetc(f);
-
-		// comment or problem definition line
-		if (c == 'c' || c == 'p') {
-			// skip this line
-			while(c != '\n') {
-				c = fgetc(f);
-			}
-
-			continue;
-		}
-		// whitespace
-		if (isspace(c))
-			continue;
-		
-		// negative
-		if (c == '-') {
-			neg = true;
-			continue;
-		}
-
-		// number
-		if (isdigit(c)) {
-			int num = c - '0';
-
-			c = fgetc(f);
-
-			while (isdigit(c)) {
-				num = num*10 + (c-'0');
-				c = fgetc(f);
-			}
-
-			if (neg) {
-				num *= -1;
-			}
-
-			neg = false;
-
-			if (num != 0) {
-				cls.push_back(num);
-			} else {
-				ClauseExchange * ncls = ClauseManager::allocClause(cls.size());
-
-				for (size_t i=0; i<cls.size(); i++) {
-				   ncls->lits[i] = cls[i];
-				}
-
-				ClauseManager::increaseClause(ncls, solvers.size());
-
-				clauses.push_back(ncls);
-
-				cls.clear();
-			}
-		}
-	}
-
-	fclose(f);
 
 	for (size_t i = 0; i < solvers.size(); i++) {
-		solvers[i]->addInitialClauses(clauses);
+		solvers[i]->addInitialClauses(formula.lits, formula.nVars);
 	}
 
 	return true;
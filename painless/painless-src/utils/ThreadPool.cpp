@@ -0,0 +1,112 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../utils/ThreadPool.h"
+
+using namespace std;
+
+void *
+ThreadPool::mainHelper(void * arg)
+{
+   Helper * helper   = (Helper *)arg;
+   ThreadPool * pool = helper->pool;
+
+   while (true) {
+      // The signal orders the setup of the loop before its tasks
+      helper->start.wait();
+
+      if (pool->stopping)
+         break;
+
+      pool->runTasks();
+
+      if (pool->nActive.fetch_sub(1) == 1)
+         pool->done.signal();
+   }
+
+   return NULL;
+}
+
+ThreadPool::ThreadPool(int nHelpers)
+{
+   task     = NULL;
+   nTasks   = 0;
+   nextTask = 0;
+   nActive  = 0;
+   stopping = false;
+
+   for (int i = 0; i < nHelpers; i++) {
+      Helper * helper = new Helper();
+
+      helper->pool   = this;
+      helper->thread = new Thread(mainHelper, helper);
+
+      helpers.push_back(helper);
+   }
+}
+
+ThreadPool::~ThreadPool()
+{
+   stopping = true;
+
+   for (size_t i = 0; i < helpers.size(); i++) {
+      helpers[i]->start.signal();
+   }
+
+   for (size_t i = 0; i < helpers.size(); i++) {
+      helpers[i]->thread->join();
+      delete helpers[i]->thread;
+      delete helpers[i];
+   }
+}
+
+void
+ThreadPool::runTasks()
+{
+   int i;
+
+   while ((i = nextTask.fetch_add(1)) < nTasks) {
+      (*task)(i);
+   }
+}
+
+void
+ThreadPool::parallelFor(int n, const function<void(int)> & task)
+{
+   if (helpers.empty() || n <= 1) {
+      for (int i = 0; i < n; i++) {
+         task(i);
+      }
+
+      return;
+   }
+
+   this->task     = &task;
+   this->nTasks   = n;
+   this->nextTask = 0;
+   this->nActive  = helpers.size();
+
+   for (size_t i = 0; i < helpers.size(); i++) {
+      helpers[i]->start.signal();
+   }
+
+   runTasks();
+
+   done.wait();
+}
@@ -0,0 +1,86 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../utils/Threading.h"
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+/// Small pool of helper threads running parallel loops.
+/// The calling thread takes part in the loop, so a pool without helper
+/// runs the loop sequentially.
+class ThreadPool
+{
+public:
+   /// Constructor.
+   ThreadPool(int nHelpers);
+
+   /// Destructor, stops and joins the helpers.
+   ~ThreadPool();
+
+   /// Run task(i) for i in [0, n), return when all the tasks are done.
+   /// Must not be called concurrently.
+   void parallelFor(int n, const function<void(int)> & task);
+
+protected:
+   /// Helper thread of the pool.
+   struct Helper
+   {
+      /// Pool of the helper.
+      ThreadPool * pool;
+
+      /// Signaled when a loop starts or the helper has to stop.
+      Condition start;
+
+      /// Thread of the helper.
+      Thread * thread;
+   };
+
+   /// Main executed by the helper threads.
+   static void * mainHelper(void * arg);
+
+   /// Run the tasks of the current loop until none is left.
+   void runTasks();
+
+   /// Helpers of the pool.
+   vector<Helper *> helpers;
+
+   /// Task of the current loop.
+   const function<void(int)> * task;
+
+   /// Number of tasks of the current loop.
+   int nTasks;
+
+   /// Index of the next task to run.
+   atomic<int> nextTask;
+
+   /// Number of helpers still working on the current loop.
+   atomic<int> nActive;
+
+   /// Signaled by the last helper finishing the current loop.
+   Condition done;
+
+   /// Are the helpers asked to stop.
+   atomic<bool> stopping;
+};
@@ -23,6 +23,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/time.h>
 #include <time.h>
 
 #define TESTRUN(cmd, msg) int res = cmd; if (res != 0) { printf(msg,res); \
@@ -68,6 +69,86 @@ protected:
    pthread_mutex_t mtx;
 };
 
+/// Condition class, a signal is kept until a waiting thread consumes it.
+class Condition
+{
+public:
+   /// Constructor.
+   Condition()
+   {
+      signaled = false;
+
+      TESTRUN(pthread_mutex_init(&mtx, NULL), "Mutex init failed with msg %d\n")
+      pthread_cond_init(&cond, NULL);
+   }
+
+   /// Destructor.
+   virtual ~Condition()
+   {
+      pthread_cond_destroy(&cond);
+      pthread_mutex_destroy(&mtx);
+   }
+
+   /// Wake up a waiting thread, or the next one to wait.
+   void signal()
+   {
+      pthread_mutex_lock(&mtx);
+      signaled = true;
+      pthread_cond_signal(&cond);
+      pthread_mutex_unlock(&mtx);
+   }
+
+   /// Wait for a signal.
+   void wait()
+   {
+      pthread_mutex_lock(&mtx);
+
+      while (signaled == false) {
+         pthread_cond_wait(&cond, &mtx);
+      }
+
+      signaled = false;
+      pthread_mutex_unlock(&mtx);
+   }
+
+   /// Wait for a signal at most a given time in microseconds.
+   /// @return true if signaled, false if the time is elapsed.
+   bool waitFor(long usec)
+   {
+      struct timeval  now;
+      struct timespec deadline;
+
+      gettimeofday(&now, NULL);
+
+      long nsec         = (now.tv_usec + usec % 1000000) * 1000;
+      deadline.tv_sec   = now.tv_sec + usec / 1000000 + nsec / 1000000000;
+      deadline.tv_nsec  = nsec % 1000000000;
+
+      pthread_mutex_lock(&mtx);
+
+      while (signaled == false) {
+         if (pthread_cond_timedwait(&cond, &mtx, &deadline) != 0)
+            break;
+      }
+
+      bool res = signaled;
+      signaled = false;
+      pthread_mutex_unlock(&mtx);
+
+      return res;
+   }
+
+protected:
+   /// A pthread mutex.
+   pthread_mutex_t mtx;
+
+   /// A pthread condition.
+   pthread_cond_t cond;
+
+   /// Is there a pending signal.
+   bool signaled;
+};
+
 /// Thread class
 class Thread
 {
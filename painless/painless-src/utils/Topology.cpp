@@ -0,0 +1,260 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../utils/Topology.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <map>
+#include <pthread.h>
+#include <sched.h>
+#include <set>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string>
+#include <tuple>
+
+#define SYSFS_CPU  "/sys/devices/system/cpu"
+#define SYSFS_NODE "/sys/devices/system/node"
+
+using namespace std;
+
+vector<int> Topology::cpus;
+vector<int> Topology::nodes;
+int         Topology::nCores = 0;
+int         Topology::nNodes = 0;
+
+// Read the first line of a sysfs file, return false if failed
+static bool
+readLine(const string & path, string & line)
+{
+   FILE * f = fopen(path.c_str(), "r");
+
+   if (f == NULL)
+      return false;
+
+   char buf[4096];
+   bool res = fgets(buf, sizeof(buf), f) != NULL;
+
+   fclose(f);
+
+   if (res)
+      line = buf;
+
+   return res;
+}
+
+// Read an integer in a sysfs file, a default value is returned if failed
+static int
+readInt(const string & path, int def)
+{
+   string line;
+
+   if (readLine(path, line) == false)
+      return def;
+
+   return atoi(line.c_str());
+}
+
+// Parse a list of CPUs of the form 0-3,8,10-11
+static vector<int>
+parseCpuList(const string & line)
+{
+   vector<int> res;
+   const char * p = line.c_str();
+
+   while (*p >= '0' && *p <= '9') {
+      char * end;
+      int first = strtol(p, &end, 10);
+      int last  = first;
+
+      if (*end == '-')
+         last = strtol(end + 1, &end, 10);
+
+      for (int cpu = first; cpu <= last; cpu++) {
+         res.push_back(cpu);
+      }
+
+      p = (*end == ',') ? end + 1 : end;
+   }
+
+   return res;
+}
+
+void
+Topology::init()
+{
+   cpu_set_t mask;
+   CPU_ZERO(&mask);
+
+   if (sched_getaffinity(0, sizeof(mask), &mask) != 0)
+      return;
+
+   string line;
+   vector<int> online;
+
+   if (readLine(SYSFS_CPU "/online", line)) {
+      online = parseCpuList(line);
+   } else {
+      for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+         online.push_back(cpu);
+      }
+   }
+
+   // Node of each CPU, a machine without NUMA support has a single node
+   map<int, int> cpuNode;
+   DIR * dir = opendir(SYSFS_NODE);
+
+   if (dir != NULL) {
+      struct dirent * entry;
+
+      while ((entry = readdir(dir)) != NULL) {
+         int node;
+
+         if (sscanf(entry->d_name, "node%d", &node) != 1)
+            continue;
+
+         if (readLine(SYSFS_NODE "/" + string(entry->d_name) + "/cpulist",
+                      line) == false)
+            continue;
+
+         vector<int> list = parseCpuList(line);
+
+         for (size_t i = 0; i < list.size(); i++) {
+            cpuNode[list[i]] = node;
+         }
+      }
+
+      closedir(dir);
+   }
+
+   // The hardware threads of a physical core are ranked by CPU id, the
+   // first ones are placed before all the siblings
+   map<pair<int, int>, int> coreThreads;
+   vector<tuple<int, int, int, int, int>> order;
+
+   for (size_t i = 0; i < online.size(); i++) {
+      int cpu = online[i];
+
+      if (CPU_ISSET(cpu, &mask) == 0)
+         continue;
+
+      string topo    = SYSFS_CPU "/cpu" + to_string(cpu) + "/topology/";
+      int package    = readInt(topo + "physical_package_id", 0);
+      int core       = readInt(topo + "core_id", cpu);
+      int node       = cpuNode.count(cpu) ? cpuNode[cpu] : 0;
+      int rank       = coreThreads[make_pair(package, core)]++;
+
+      order.push_back(make_tuple(rank, node, package, core, cpu));
+   }
+
+   sort(order.begin(), order.end());
+
+   set<int> distinctNodes;
+
+   cpus.clear();
+   nodes.clear();
+
+   for (size_t i = 0; i < order.size(); i++) {
+      cpus.push_back(get<4>(order[i]));
+      nodes.push_back(get<1>(order[i]));
+      distinctNodes.insert(get<1>(order[i]));
+   }
+
+   nCores = coreThreads.size();
+   nNodes = distinctNodes.size();
+}
+
+bool
+Topology::isEnabled()
+{
+   return cpus.empty() == false;
+}
+
+int
+Topology::getCpusCount()
+{
+   return cpus.size();
+}
+
+int
+Topology::getCoresCount()
+{
+   return nCores;
+}
+
+int
+Topology::getNodesCount()
+{
+   return nNodes;
+}
+
+int
+Topology::getSolverCpu(int id)
+{
+   if (cpus.empty())
+      return -1;
+
+   return cpus[id % cpus.size()];
+}
+
+bool
+Topology::pinSolver(int id)
+{
+   if (cpus.empty())
+      return false;
+
+   return pin(vector<int>(1, getSolverCpu(id)));
+}
+
+bool
+Topology::pinNear(const vector<int> & ids)
+{
+   if (cpus.empty() || ids.empty())
+      return false;
+
+   set<int> near;
+
+   for (size_t i = 0; i < ids.size(); i++) {
+      near.insert(nodes[ids[i] % cpus.size()]);
+   }
+
+   vector<int> set;
+
+   for (size_t i = 0; i < cpus.size(); i++) {
+      if (near.count(nodes[i])) {
+         set.push_back(cpus[i]);
+      }
+   }
+
+   return pin(set);
+}
+
+bool
+Topology::pin(const vector<int> & set)
+{
+   cpu_set_t mask;
+   CPU_ZERO(&mask);
+
+   for (size_t i = 0; i < set.size(); i++) {
+      CPU_SET(set[i], &mask);
+   }
+
+   return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+}
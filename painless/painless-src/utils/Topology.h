@@ -0,0 +1,73 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+/// Process-wide CPU topology, read from sysfs, and thread placement.
+/// The placement order takes one hardware thread per physical core, the
+/// cores of a NUMA node being contiguous, before the sibling hardware
+/// threads. A solver is pinned to the CPU of its id in this order, so
+/// neighbouring solvers share a node, and a sharer is pinned to the nodes
+/// of its producers.
+class Topology
+{
+public:
+   /// Read the topology of the CPUs usable by the process.
+   static void init();
+
+   /// Is the placement enabled.
+   static bool isEnabled();
+
+   /// Return the number of usable CPUs.
+   static int getCpusCount();
+
+   /// Return the number of physical cores of the usable CPUs.
+   static int getCoresCount();
+
+   /// Return the number of NUMA nodes of the usable CPUs.
+   static int getNodesCount();
+
+   /// Return the CPU of a solver in the placement order.
+   static int getSolverCpu(int id);
+
+   /// Pin the calling thread to the CPU of a solver, return false if failed.
+   static bool pinSolver(int id);
+
+   /// Pin the calling thread to the NUMA nodes of a set of solvers, return
+   /// false if failed.
+   static bool pinNear(const vector<int> & ids);
+
+protected:
+   /// Usable CPUs in the placement order.
+   static vector<int> cpus;
+
+   /// NUMA node of each usable CPU, in the placement order.
+   static vector<int> nodes;
+
+   /// Number of physical cores and NUMA nodes.
+   static int nCores;
+   static int nNodes;
+
+   /// Pin the calling thread to a set of CPUs.
+   static bool pin(const vector<int> & set);
+};
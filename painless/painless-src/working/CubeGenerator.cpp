@@ -0,0 +1,268 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../utils/Logger.h"
+#include "../utils/System.h"
+#include "../working/CubeGenerator.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+
+/// Order of the nodes in the heap, the node assigning the fewest variables
+/// is on top.
+static bool
+lessPriority(const CubeNode & a, const CubeNode & b)
+{
+   return a.assigned > b.assigned;
+}
+
+CubeGenerator::CubeGenerator(const vector<SolverInterface *> & solvers,
+                             int nCandidates)
+{
+   this->solvers     = solvers;
+   this->pool        = new ThreadPool(solvers.size() - 1);
+   this->nCandidates = nCandidates;
+   this->nFailed     = 0;
+   this->nRefuted    = 0;
+
+   vector<int> occ = solvers[0]->getOccurrences();
+
+   for (size_t v = 1; v < occ.size(); v++) {
+      order.push_back(v);
+   }
+
+   stable_sort(order.begin(), order.end(), [&occ](int a, int b) {
+      return occ[a] > occ[b];
+   });
+}
+
+CubeGenerator::~CubeGenerator()
+{
+   delete pool;
+}
+
+bool
+CubeGenerator::generate(const vector<int> & root, int nCubes,
+                        vector<vector<int> > & cubes)
+{
+   double start = getRelativeTime();
+   int assigned;
+   vector<int> counts;
+
+   if (solvers[0]->lookahead(root, vector<int>(), assigned, counts) == false)
+      return false;
+
+   vector<CubeNode> heap;
+   vector<CubeNode> leaves;
+
+   CubeNode node;
+   node.cube     = root;
+   node.assigned = 0;
+   heap.push_back(node);
+
+   while (heap.empty() == false && heap.size() + leaves.size() < nCubes) {
+      // A split adds at most one cube
+      int need  = nCubes - heap.size() - leaves.size();
+      int batch = min(min(need, (int)solvers.size()), (int)heap.size());
+
+      vector<CubeNode> nodes(batch);
+
+      for (int i = 0; i < batch; i++) {
+         pop_heap(heap.begin(), heap.end(), lessPriority);
+         nodes[i] = heap.back();
+         heap.pop_back();
+      }
+
+      vector<vector<CubeNode> > children(batch);
+      vector<char> splitted(batch);
+      vector<char> refuted(batch);
+
+      pool->parallelFor(batch, [&](int i) {
+         bool ref    = false;
+         splitted[i] = split(solvers[i], nodes[i], children[i], ref);
+         refuted[i]  = ref;
+      });
+
+      for (int i = 0; i < batch; i++) {
+         if (refuted[i])
+            continue;
+
+         if (splitted[i] == false) {
+            leaves.push_back(nodes[i]);
+            continue;
+         }
+
+         for (size_t j = 0; j < children[i].size(); j++) {
+            heap.push_back(children[i][j]);
+            push_heap(heap.begin(), heap.end(), lessPriority);
+         }
+      }
+   }
+
+   cubes.clear();
+
+   for (size_t i = 0; i < heap.size(); i++) {
+      cubes.push_back(heap[i].cube);
+   }
+
+   for (size_t i = 0; i < leaves.size(); i++) {
+      cubes.push_back(leaves[i].cube);
+   }
+
+   log(1, "Cube generation: %d cubes in %.2f s, %lu failed literals, %lu " \
+       "refuted cubes\n", (int)cubes.size(), getRelativeTime() - start,
+       (unsigned long)nFailed, (unsigned long)nRefuted);
+
+   return true;
+}
+
+bool
+CubeGenerator::split(SolverInterface * solver, CubeNode & node,
+                     vector<CubeNode> & children, bool & refuted)
+{
+   // The candidates are the most frequent variables not in the cube
+   vector<int> inCube(node.cube.begin(), node.cube.end());
+   vector<int> lits;
+
+   for (size_t i = 0; i < inCube.size(); i++) {
+      inCube[i] = abs(inCube[i]);
+   }
+
+   sort(inCube.begin(), inCube.end());
+
+   for (size_t i = 0; i < order.size() && lits.size() < 2 * nCandidates;
+        i++)
+   {
+      if (binary_search(inCube.begin(), inCube.end(), order[i]) == false) {
+         lits.push_back(order[i]);
+         lits.push_back(-order[i]);
+      }
+   }
+
+   int assigned;
+   vector<int> counts;
+
+   if (solver->lookahead(node.cube, lits, assigned, counts) == false)
+      return false;
+
+   if (assigned < 0) {
+      refuted = true;
+      nRefuted++;
+      return false;
+   }
+
+   node.assigned = assigned;
+
+   int best            = 0;
+   int bestPos         = 0;
+   int bestNeg         = 0;
+   long long bestScore = -1;
+
+   for (size_t i = 0; i < lits.size(); i += 2) {
+      int pos = counts[i];
+      int neg = counts[i + 1];
+
+      // The variable is assigned by the cube
+      if (pos == 0 || neg == 0)
+         continue;
+
+      if (pos < 0 && neg < 0) {
+         refuted = true;
+         nRefuted++;
+         return false;
+      }
+
+      // A failed literal, the cube is extended and split again later
+      if (pos < 0 || neg < 0) {
+         CubeNode child;
+         child.cube = node.cube;
+         child.cube.push_back(pos < 0 ? -lits[i] : lits[i]);
+         child.assigned = assigned + (pos < 0 ? neg : pos);
+         children.push_back(child);
+         nFailed++;
+         return true;
+      }
+
+      long long score = (long long)pos * neg;
+
+      if (score > bestScore) {
+         best      = lits[i];
+         bestPos   = pos;
+         bestNeg   = neg;
+         bestScore = score;
+      }
+   }
+
+   if (best == 0)
+      return false;
+
+   CubeNode child;
+   child.cube = node.cube;
+   child.cube.push_back(best);
+   child.assigned = assigned + bestPos;
+   children.push_back(child);
+
+   child.cube.back() = -best;
+   child.assigned    = assigned + bestNeg;
+   children.push_back(child);
+
+   return true;
+}
+
+bool
+CubeGenerator::writeIcnf(const Formula & cnf, const char * filename,
+                         const vector<vector<int> > & cubes)
+{
+   FILE * out = fopen(filename, "w");
+
+   if (out == NULL)
+      return false;
+
+   // The clauses are written from the parsed formula, so any input format
+   // can be converted
+   fprintf(out, "p inccnf\n");
+
+   bool lineStart = true;
+
+   for (size_t i = 0; i < cnf.lits.size(); i++) {
+      fprintf(out, lineStart ? "%d" : " %d", cnf.lits[i]);
+
+      lineStart = cnf.lits[i] == 0;
+
+      if (lineStart) {
+         fprintf(out, "\n");
+      }
+   }
+
+   for (size_t i = 0; i < cubes.size(); i++) {
+      fprintf(out, "a");
+
+      for (size_t j = 0; j < cubes[i].size(); j++) {
+         fprintf(out, " %d", cubes[i][j]);
+      }
+
+      fprintf(out, " 0\n");
+   }
+
+   return fclose(out) == 0;
+}
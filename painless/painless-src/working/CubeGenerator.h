@@ -0,0 +1,89 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../solvers/SolverInterface.h"
+#include "../utils/Formula.h"
+#include "../utils/ThreadPool.h"
+
+#include <vector>
+
+using namespace std;
+
+/// Cube of the generation and the number of variables it assigns.
+struct CubeNode
+{
+   /// Literals of the cube.
+   vector<int> cube;
+
+   /// Number of variables assigned by the propagation of the cube.
+   int assigned;
+};
+
+/// Lookahead cube generator, for cube and conquer.
+/// The cube assigning the fewest variables, the largest part of the search
+/// space, is split first. It is split on the variable maximizing the product
+/// of the numbers of variables assigned by its two literals (march like
+/// heuristic). A failed literal extends the cube with its negation, and a
+/// cube whose both branches fail is refuted. Each thread of the generator
+/// has its own lookahead solver and splits one cube of a batch.
+class CubeGenerator
+{
+public:
+   /// Constructor, the solvers must support the lookahead, a thread is
+   /// used per solver.
+   CubeGenerator(const vector<SolverInterface *> & solvers, int nCandidates);
+
+   /// Destructor.
+   ~CubeGenerator();
+
+   /// Split a cube until there are nCubes cubes, or no cube can be split.
+   /// The refuted cubes are removed, so no cube means UNSAT.
+   /// Return false if the lookahead is not supported.
+   bool generate(const vector<int> & root, int nCubes,
+                 vector<vector<int> > & cubes);
+
+   /// Write the clauses of a formula and cubes in the iCNF format.
+   static bool writeIcnf(const Formula & cnf, const char * filename,
+                         const vector<vector<int> > & cubes);
+
+protected:
+   /// Split a cube with a solver, the children are put in children.
+   /// Return false if the cube cannot be split, the cube is then a leaf if
+   /// it is not refuted.
+   bool split(SolverInterface * solver, CubeNode & node,
+              vector<CubeNode> & children, bool & refuted);
+
+   /// Lookahead solvers, one per thread.
+   vector<SolverInterface *> solvers;
+
+   /// Threads of the generation.
+   ThreadPool * pool;
+
+   /// Variables by decreasing number of occurrences.
+   vector<int> order;
+
+   /// Number of variables looked ahead per cube.
+   int nCandidates;
+
+   /// Numbers of failed literals and refuted cubes.
+   atomic<unsigned long> nFailed;
+   atomic<unsigned long> nRefuted;
+};
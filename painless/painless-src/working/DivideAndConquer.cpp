@@ -0,0 +1,337 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../utils/Logger.h"
+#include "../working/DivideAndConquer.h"
+#include "../working/SequentialWorker.h"
+
+#include <algorithm>
+
+using namespace std;
+
+DivideAndConquer::DivideAndConquer()
+{
+   strategyEnding = false;
+   nSplits        = 0;
+   nPruned        = 0;
+}
+
+DivideAndConquer::~DivideAndConquer()
+{
+   for (size_t i = 0; i < slaves.size(); i++) {
+      delete slaves[i];
+   }
+}
+
+void
+DivideAndConquer::addSlave(WorkingStrategy * slave)
+{
+   WorkingStrategy::addSlave(slave);
+
+   states.push_back(DcSlave());
+}
+
+void
+DivideAndConquer::setCubes(const vector<vector<int> > & cubes)
+{
+   lock.lock();
+
+   pending.assign(cubes.begin(), cubes.end());
+
+   lock.unlock();
+}
+
+void
+DivideAndConquer::solve(const vector<int> & cube)
+{
+   lock.lock();
+
+   strategyEnding = false;
+
+   idle.clear();
+
+   for (size_t i = 0; i < states.size(); i++) {
+      states[i] = DcSlave();
+      idle.push_back(i);
+   }
+
+   // Without pending cubes, the first slave takes the cube and the others
+   // steal parts of it
+   if (states.size() > 0) {
+      if (pending.empty()) {
+         idle.pop_front();
+         assign(0, cube);
+      }
+
+      balance();
+   }
+
+   lock.unlock();
+}
+
+void
+DivideAndConquer::join(WorkingStrategy * strat, SatResult res,
+                       const vector<int> & model)
+{
+   if (strategyEnding || globalEnding)
+      return;
+
+   lock.lock();
+
+   if (strategyEnding) {
+      lock.unlock();
+      return;
+   }
+
+   int id         = indexOf(strat);
+   DcSlave & self = states[id];
+
+   if (res == SAT) {
+      end(SAT, model);
+      lock.unlock();
+      return;
+   }
+
+   if (res == UNSAT && self.pruned == false) {
+      // The final conflict is the negation of the refuting assumptions
+      SolverInterface * solver = ((SequentialWorker *)strat)->solver;
+      vector<int> refuted      = solver->getFinalAnalysis();
+
+      for (size_t i = 0; i < refuted.size(); i++) {
+         refuted[i] = -refuted[i];
+      }
+
+      if (refuted.empty()) {
+         end(UNSAT, model);
+         lock.unlock();
+         return;
+      }
+
+      sort(refuted.begin(), refuted.end());
+
+      // Prune the cubes of the other slaves containing the refuted part
+      for (size_t i = 0; i < states.size(); i++) {
+         DcSlave & other = states[i];
+
+         if (i == id || other.busy == false || other.pruned)
+            continue;
+
+         vector<int> cube(other.cube);
+         sort(cube.begin(), cube.end());
+
+         if (includes(cube.begin(), cube.end(), refuted.begin(),
+                      refuted.end()))
+         {
+            other.pruned = true;
+            slaves[i]->setInterrupt();
+            nPruned++;
+         }
+      }
+
+      deque<vector<int> > kept;
+
+      for (size_t i = 0; i < pending.size(); i++) {
+         vector<int> cube(pending[i]);
+         sort(cube.begin(), cube.end());
+
+         if (includes(cube.begin(), cube.end(), refuted.begin(),
+                      refuted.end()))
+         {
+            nPruned++;
+         } else {
+            kept.push_back(pending[i]);
+         }
+      }
+
+      pending.swap(kept);
+   }
+
+   if (res == UNSAT || self.pruned) {
+      // The cube is refuted, the slave and its thief are idle
+      self.busy   = false;
+      self.pruned = false;
+      idle.push_back(id);
+
+      if (self.thief >= 0) {
+         idle.push_back(self.thief);
+         self.thief = -1;
+      }
+   } else if (self.thief >= 0) {
+      // Interrupted for a steal, the solver of the slave is not running
+      int var   = strat->getDivisionVariable();
+      int thief = self.thief;
+
+      self.thief = -1;
+
+      if (var == 0) {
+         self.splittable = false;
+         idle.push_back(thief);
+         assign(id, self.cube);
+      } else {
+         vector<int> half(self.cube);
+         half.push_back(-var);
+         assign(thief, half);
+
+         half.back() = var;
+         assign(id, half);
+
+         nSplits++;
+
+         log(2, "Divide and conquer: split %lu on variable %d, cube of " \
+             "%d literals\n", nSplits, var, (int)half.size());
+      }
+   } else {
+      // Interrupted by the parent, the strategy is ending
+      lock.unlock();
+      return;
+   }
+
+   balance();
+
+   bool busy = false;
+
+   for (size_t i = 0; i < states.size(); i++) {
+      busy |= states[i].busy;
+   }
+
+   if (busy == false) {
+      end(UNSAT, model);
+   }
+
+   lock.unlock();
+}
+
+void
+DivideAndConquer::balance()
+{
+   while (idle.empty() == false && pending.empty() == false) {
+      assign(idle.front(), pending.front());
+      idle.pop_front();
+      pending.pop_front();
+   }
+
+   while (idle.empty() == false) {
+      // The victim has the shortest cube, the largest part of the space
+      int victim = -1;
+
+      for (size_t i = 0; i < states.size(); i++) {
+         DcSlave & st = states[i];
+
+         if (st.busy == false || st.pruned || st.splittable == false ||
+             st.thief >= 0)
+            continue;
+
+         if (victim < 0 || st.cube.size() < states[victim].cube.size())
+            victim = i;
+      }
+
+      if (victim < 0)
+         return;
+
+      states[victim].thief = idle.front();
+      idle.pop_front();
+
+      slaves[victim]->setInterrupt();
+   }
+}
+
+void
+DivideAndConquer::assign(int slave, const vector<int> & cube)
+{
+   states[slave].cube = cube;
+   states[slave].busy = true;
+
+   slaves[slave]->solve(cube);
+}
+
+void
+DivideAndConquer::end(SatResult res, const vector<int> & model)
+{
+   strategyEnding = true;
+
+   log(1, "Divide and conquer: %lu splits, %lu pruned cubes\n", nSplits,
+       nPruned);
+
+   setInterrupt();
+
+   if (parent == NULL) {
+      // The result is written before the end is visible to other threads
+      finalResult = res;
+
+      if (res == SAT) {
+         finalModel = model;
+      }
+
+      globalEnding = true;
+      endingSignal.signal();
+   } else {
+      parent->join(this, res, model);
+   }
+}
+
+int
+DivideAndConquer::indexOf(WorkingStrategy * slave)
+{
+   for (size_t i = 0; i < slaves.size(); i++) {
+      if (slaves[i] == slave)
+         return i;
+   }
+
+   return -1;
+}
+
+void
+DivideAndConquer::setInterrupt()
+{
+   for (size_t i = 0; i < slaves.size(); i++) {
+      slaves[i]->setInterrupt();
+   }
+}
+
+void
+DivideAndConquer::unsetInterrupt()
+{
+   for (size_t i = 0; i < slaves.size(); i++) {
+      slaves[i]->unsetInterrupt();
+   }
+}
+
+void
+DivideAndConquer::waitInterrupt()
+{
+   for (size_t i = 0; i < slaves.size(); i++) {
+      slaves[i]->waitInterrupt();
+   }
+}
+
+int
+DivideAndConquer::getDivisionVariable()
+{
+   return 0;
+}
+
+void
+DivideAndConquer::setPhase(int var, bool value)
+{
+}
+
+void
+DivideAndConquer::bumpVariableActivity(int var, int times)
+{
+}
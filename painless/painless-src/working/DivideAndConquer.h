@@ -0,0 +1,126 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2017  Ludovic LE FRIOUX
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../utils/Threading.h"
+#include "../working/WorkingStrategy.h"
+
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+/// State of a slave of a divide and conquer strategy.
+struct DcSlave
+{
+   /// Constructor.
+   DcSlave()
+   {
+      busy       = false;
+      splittable = true;
+      pruned     = false;
+      thief      = -1;
+   }
+
+   /// Cube solved by the slave.
+   vector<int> cube;
+
+   /// Is the slave solving its cube.
+   bool busy;
+
+   /// Can the cube of the slave be split.
+   bool splittable;
+
+   /// Has the cube been refuted by another slave.
+   bool pruned;
+
+   /// Idle slave waiting for half of the cube, -1 if none.
+   int thief;
+};
+
+/// Divide and conquer strategy, the slaves (sequential workers) solve
+/// disjoint cubes. An idle slave takes a pending cube if any, else it steals
+/// work from the busy slave with the
+/// shortest cube: this victim is interrupted, and its cube is split on its
+/// division variable in its own thread. The victim takes one half and the
+/// thief takes the other. The assumptions refuting a cube prune the cubes
+/// of the other slaves containing them. The formula is unsatisfiable once
+/// no slave is busy.
+class DivideAndConquer : public WorkingStrategy
+{
+public:
+   DivideAndConquer();
+
+   ~DivideAndConquer();
+
+   void solve(const vector<int> & cube);
+
+   void join(WorkingStrategy * strat, SatResult res,
+             const vector<int> & model);
+
+   void setInterrupt();
+
+   void unsetInterrupt();
+
+   void waitInterrupt();
+
+   int getDivisionVariable();
+
+   void setPhase(int var, bool value);
+
+   void bumpVariableActivity(int var, int times);
+
+   void addSlave(WorkingStrategy * slave);
+
+   /// Set cubes given to the idle slaves before any steal, e.g. generated
+   /// by lookahead. They replace the cube given to solve.
+   void setCubes(const vector<vector<int> > & cubes);
+
+protected:
+   /// Give the idle slaves to busy slaves, the lock must be held.
+   void balance();
+
+   /// Give a cube to a slave, the lock must be held.
+   void assign(int slave, const vector<int> & cube);
+
+   /// End the strategy with a result, the lock must be held.
+   void end(SatResult res, const vector<int> & model);
+
+   /// Return the index of a slave.
+   int indexOf(WorkingStrategy * slave);
+
+   /// States of the slaves.
+   vector<DcSlave> states;
+
+   /// Idle slaves without victim.
+   deque<int> idle;
+
+   /// Cubes not yet given to a slave.
+   deque<vector<int> > pending;
+
+   /// Lock protecting the states.
+   Mutex lock;
+
+   atomic<bool> strategyEnding;
+
+   /// Number of splits and pruned cubes.
+   unsigned long nSplits;
+   unsigned long nPruned;
+};
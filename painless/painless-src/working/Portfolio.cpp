@@ -57,12 +57,15 @@ Portfolio::join(WorkingStrategy * strat, SatResult res,
    setInterrupt();         
 
    if (parent == NULL) { // If it is the top strategy
-      globalEnding = true;
+      // The result is written before the end is visible to other threads
       finalResult  = res;
 
       if (res == SAT) {
          finalModel = model;
       }
+
+      globalEnding = true;
+      endingSignal.signal();
       SequentialWorker *winner = (SequentialWorker*)strat;
       // log(0, "The winner is thread %d \\o/ !!!\n", winner->solver->id);
    } else { // Else forward the information to the parent strategy
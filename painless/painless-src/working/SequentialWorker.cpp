@@ -18,6 +18,7 @@
 // -----------------------------------------------------------------------------
 
 #include "../utils/Logger.h"
+#include "../utils/Topology.h"
 #include "../working/SequentialWorker.h"
 
 #include <unistd.h>
@@ -33,19 +34,33 @@ void * mainWorker(void *arg)
 
    vector<int> model;
 
-   while (globalEnding == false && sq->force == false) {
+   // With a placement, the memory allocated from now on by the solver is
+   // local to the node of its CPU
+   if (Topology::isEnabled() && Topology::pinSolver(sq->solver->id)) {
+      sq->solver->localizeMemory();
+   }
+
+   // A worker solves the jobs given by its strategy until the end
+   while (globalEnding == false) {
       pthread_mutex_lock(&sq->mutexStart);
 
-      if (sq->waitJob == true) {
+      while (sq->waitJob == true && sq->exiting == false) {
          pthread_cond_wait(&sq->mutexCondStart, &sq->mutexStart);
       }
 
+      // The job is taken, the strategy may give another one during the join
+      vector<int> cube = sq->actualCube;
+      sq->waitJob      = true;
+
       pthread_mutex_unlock(&sq->mutexStart);
 
+      if (sq->exiting)
+         break;
+
       sq->waitInterruptLock.lock();
 
       do {
-         res = sq->solver->solve(sq->actualCube);
+         res = sq->solver->solve(cube);
       } while (sq->force == false && res == UNKNOWN);
 
       sq->waitInterruptLock.unlock();
@@ -57,10 +72,11 @@ void * mainWorker(void *arg)
       sq->join(NULL, res, model);
 
       model.clear();
-
-      sq->waitJob = true;
    }
 
+   // A stopped solver must not hold back the reclamation of the logs
+   sq->solver->unsubscribeClauseLogs();
+
    return NULL;
 }
 
@@ -70,6 +86,7 @@ SequentialWorker::SequentialWorker(SolverInterface * solver_)
    solver  = solver_;
    force   = false;
    waitJob = true;
+   exiting = false;
 
    pthread_mutex_init(&mutexStart, NULL);
    pthread_cond_init (&mutexCondStart, NULL);
@@ -82,6 +99,11 @@ SequentialWorker::~SequentialWorker()
 {
    setInterrupt();
 
+   pthread_mutex_lock  (&mutexStart);
+   exiting = true;
+   pthread_cond_signal (&mutexCondStart);
+   pthread_mutex_unlock(&mutexStart);
+
    worker->join();
    delete worker;
 
@@ -94,13 +116,14 @@ SequentialWorker::~SequentialWorker()
 void
 SequentialWorker::solve(const vector<int> & cube)
 {
+   pthread_mutex_lock  (&mutexStart);
+
    actualCube = cube;
-   
+
    unsetInterrupt();
 
    waitJob = false;
 
-   pthread_mutex_lock  (&mutexStart);
    pthread_cond_signal (&mutexCondStart);
    pthread_mutex_unlock(&mutexStart);
 }
@@ -115,12 +138,15 @@ SequentialWorker::join(WorkingStrategy * winner, SatResult res,
       return;
 
    if (parent == NULL) {
-      globalEnding = true;
+      // The result is written before the end is visible to other threads
       finalResult  = res;
 
       if (res == SAT) {
          finalModel = model;
       }
+
+      globalEnding = true;
+      endingSignal.signal();
    } else {
       parent->join(this, res, model);
    }
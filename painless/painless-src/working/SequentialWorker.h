@@ -67,6 +67,8 @@ protected:
    
    atomic<bool> waitJob;
 
+   atomic<bool> exiting;
+
    Mutex waitInterruptLock;
 
    pthread_mutex_t mutexStart;
@@ -20,6 +20,7 @@
 #pragma once
 
 #include "../solvers/SolverInterface.h"
+#include "../utils/Threading.h"
 
 #include <vector>
 
@@ -27,6 +28,8 @@ using namespace std;
 
 extern atomic<bool> globalEnding;
 
+extern Condition endingSignal;
+
 extern SatResult finalResult;
 
 extern vector<int> finalModel;
@@ -1,2 +1,9 @@
 #!/bin/bash
-/painless/painless-mcomsps -c=28 -shr-sleep=750000 -shr-strat=3 $2
+# $1: hostfile of the nodes, $2: formula
+# With several nodes, one painless process per node shares clauses via MPI
+if [ -f "$1" ] && [ $(grep -c . "$1") -gt 1 ]; then
+   mpirun --allow-run-as-root --hostfile $1 -npernode 1 --bind-to none \
+      /painless/painless-mcomsps -c=28 -shr-sleep=750000 -shr-strat=3 $2
+else
+   /painless/painless-mcomsps -c=28 -shr-sleep=750000 -shr-strat=3 $2
+fi